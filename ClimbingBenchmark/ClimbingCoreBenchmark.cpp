@@ -0,0 +1,203 @@
+/* Copyright 2019 Alexandrea Shackelford, Zion Nimchuk, All Rights Reserved.
+ * Unauthorized copying or modification of this file, via any medium is strictly prohibited.
+ */
+
+/**
+ * Standalone benchmark for the engine independent climbing core. Builds synthetic scenes of climbables around the player
+ * and times candidate scoring plus selection for every detection type, so changes to the scoring can be measured outside
+ * of the editor. Also checks that the vector and scalar scoring pick the same climbables.
+ */
+
+#include "../ClimbingSystem/ClimbingCore.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace ClimbingCore;
+
+namespace
+{
+	constexpr float DegreesToRadians = 0.0174532925199432957692f;
+	constexpr float DetectionRadius = 800.0f;
+
+	struct FScene
+	{
+		std::vector<float> PositionX;
+		std::vector<float> PositionY;
+		std::vector<float> PositionZ;
+		std::vector<float> Yaw;
+		std::vector<float> Pitch;
+		std::vector<float> Eligible;
+		std::vector<float> Ratings;
+		int Num = 0;
+
+		FCandidateArrays GetArrays()
+		{
+			FCandidateArrays Arrays;
+			Arrays.PositionX = PositionX.data();
+			Arrays.PositionY = PositionY.data();
+			Arrays.PositionZ = PositionZ.data();
+			Arrays.Yaw = Yaw.data();
+			Arrays.Pitch = Pitch.data();
+			Arrays.Eligible = Eligible.data();
+			Arrays.Ratings = Ratings.data();
+			return Arrays;
+		}
+	};
+
+	/* Crystals scattered through the detection sphere, facing roughly the same way as the player like they do in the levels*/
+	FScene MakeScene(int Num, std::mt19937& Random)
+	{
+		std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> Angle(-90.0f, 90.0f);
+		std::uniform_real_distribution<float> Chance(0.0f, 1.0f);
+
+		FScene Scene;
+		Scene.Num = Num;
+		const auto PaddedNum = PadCandidateCount(Num);
+		Scene.PositionX.assign(PaddedNum, 0.0f);
+		Scene.PositionY.assign(PaddedNum, 0.0f);
+		Scene.PositionZ.assign(PaddedNum, 0.0f);
+		Scene.Yaw.assign(PaddedNum, 0.0f);
+		Scene.Pitch.assign(PaddedNum, 0.0f);
+		Scene.Eligible.assign(PaddedNum, 0.0f);
+		Scene.Ratings.assign(PaddedNum, 0.0f);
+
+		for (int i = 0; i < Num; i++)
+		{
+			Scene.PositionX[i] = Unit(Random) * DetectionRadius;
+			Scene.PositionY[i] = Unit(Random) * DetectionRadius;
+			Scene.PositionZ[i] = Unit(Random) * DetectionRadius;
+			Scene.Yaw[i] = Angle(Random);
+			Scene.Pitch[i] = Angle(Random) * 0.5f;
+
+			// A few crystals are always broken or already thrown out by the actor checks
+			Scene.Eligible[i] = Chance(Random) < 0.95f ? 1.0f : 0.0f;
+		}
+
+		return Scene;
+	}
+
+	FVec3 YawToVector(float Yaw)
+	{
+		return {std::cos(Yaw * DegreesToRadians), std::sin(Yaw * DegreesToRadians), 0.0f};
+	}
+
+	/* A player somewhere in the scene, pushing the stick in some direction*/
+	FScoringInputs MakeInputs(EDetectionType DetectionType, std::mt19937& Random)
+	{
+		std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> Angle(-180.0f, 180.0f);
+
+		FScoringInputs Inputs;
+		Inputs.DetectionType = DetectionType;
+		Inputs.bIsAttached = DetectionType == EDetectionType::IsClimbing;
+		Inputs.bIsOnGround = DetectionType == EDetectionType::Walking;
+		Inputs.Origin = {Unit(Random) * 100.0f, Unit(Random) * 100.0f, Unit(Random) * 100.0f};
+
+		const auto OwnerYaw = Angle(Random) * 0.25f;
+		const auto InputYaw = OwnerYaw + Angle(Random);
+		Inputs.LocalAxisX = YawToVector(OwnerYaw);
+		Inputs.DirectionAxisX = YawToVector(InputYaw);
+		Inputs.DirectionAxisY = YawToVector(InputYaw + 90.0f);
+		Inputs.OwnerYaw = OwnerYaw;
+		Inputs.OwnerPitch = 0.0f;
+		Inputs.CapsuleHalfHeight = 90.0f;
+		Inputs.MaxForwardGroundJumpDistance = 100.0f;
+		Inputs.MaxForwardThrownDistance = 20.0f;
+		Inputs.MaxYawDelta = 45.0f;
+		Inputs.MaxPitchDelta = 45.0f;
+		return Inputs;
+	}
+
+	const char* GetDetectionTypeName(EDetectionType DetectionType)
+	{
+		switch (DetectionType)
+		{
+		case EDetectionType::Walking:
+			return "Walking";
+		case EDetectionType::InAir:
+			return "InAir";
+		case EDetectionType::ForwardInAir:
+			return "ForwardInAir";
+		default:
+			return "IsClimbing";
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const int TotalCandidatesPerRun = argc > 1 ? std::atoi(argv[1]) : 20000000;
+	const int SceneSizes[] = {10, 100, 1000, 10000, 100000};
+	const EDetectionType DetectionTypes[] = {
+		EDetectionType::Walking, EDetectionType::InAir, EDetectionType::ForwardInAir, EDetectionType::IsClimbing
+	};
+
+	// Fixed seed, so every run measures the same scenes
+	std::mt19937 Random(1234);
+
+	std::printf("%-13s %10s %10s %14s %18s %14s\n", "Detection", "Climbables", "Queries", "ns/query", "candidates/sec", "scalar ns/query");
+
+	for (const auto SceneSize : SceneSizes)
+	{
+		auto Scene = MakeScene(SceneSize, Random);
+		const auto Arrays = Scene.GetArrays();
+		const auto PaddedNum = PadCandidateCount(Scene.Num);
+		const auto NumQueries = TotalCandidatesPerRun / SceneSize > 1 ? TotalCandidatesPerRun / SceneSize : 1;
+
+		for (const auto DetectionType : DetectionTypes)
+		{
+			std::vector<FScoringParams> Queries;
+			Queries.reserve(NumQueries);
+			for (int i = 0; i < NumQueries; i++)
+			{
+				Queries.push_back(MakeScoringParams(MakeInputs(DetectionType, Random)));
+			}
+
+			// Every pick is kept, which also keeps the compiler from throwing the work away
+			std::vector<int> VectorPicks(NumQueries);
+			std::vector<int> ScalarPicks(NumQueries);
+
+			const auto VectorStart = std::chrono::steady_clock::now();
+			for (int i = 0; i < NumQueries; i++)
+			{
+				ScoreCandidates(Queries[i], Arrays, 0, PaddedNum);
+				VectorPicks[i] = FindBestCandidate(Scene.Ratings.data(), Scene.Num);
+			}
+			const auto VectorEnd = std::chrono::steady_clock::now();
+
+			const auto ScalarStart = std::chrono::steady_clock::now();
+			for (int i = 0; i < NumQueries; i++)
+			{
+				ScoreCandidatesScalar(Queries[i], Arrays, 0, PaddedNum);
+				ScalarPicks[i] = FindBestCandidate(Scene.Ratings.data(), Scene.Num);
+			}
+			const auto ScalarEnd = std::chrono::steady_clock::now();
+
+			// Compared query by query, so one disagreement can't hide behind another
+			for (int i = 0; i < NumQueries; i++)
+			{
+				if (VectorPicks[i] != ScalarPicks[i])
+				{
+					std::printf("Vector and scalar scoring disagree for %s with %d climbables on query %d: vector picked %d, scalar picked %d\n",
+						GetDetectionTypeName(DetectionType), SceneSize, i, VectorPicks[i], ScalarPicks[i]);
+					return 1;
+				}
+			}
+
+			const auto VectorNanoseconds = std::chrono::duration<double, std::nano>(VectorEnd - VectorStart).count();
+			const auto ScalarNanoseconds = std::chrono::duration<double, std::nano>(ScalarEnd - ScalarStart).count();
+			const auto NanosecondsPerQuery = VectorNanoseconds / NumQueries;
+			const auto CandidatesPerSecond = static_cast<double>(SceneSize) * NumQueries / (VectorNanoseconds * 1e-9);
+
+			std::printf("%-13s %10d %10d %14.1f %18.3e %14.1f\n", GetDetectionTypeName(DetectionType), SceneSize, NumQueries,
+				NanosecondsPerQuery, CandidatesPerSecond, ScalarNanoseconds / NumQueries);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,14 @@
+@echo off
+rem Headless climbing perf capture. Spawns a load in front of the player on <Map>, times 1800 frames of it, and exits with 1 if
+rem the climbing ticks went over Climbing.Perf.BudgetP95, Climbing.Perf.BudgetP99 or Climbing.Perf.MaxAllocations.
+rem
+rem     RunClimbingPerfCapture.bat <UE4Editor-Cmd.exe> <TheElder.uproject> <Map>
+
+setlocal
+if "%~3"=="" (
+	echo Usage: %~nx0 ^<UE4Editor-Cmd.exe^> ^<TheElder.uproject^> ^<Map^>
+	exit /b 2
+)
+
+"%~1" "%~2" %3 -game -nullrhi -unattended -nosplash -trace=cpu,bookmark -ExecCmds="Climbing.Perf.Spawn Climbables=2000 Ledges=200 Climbers=20, Climbing.Perf.Run 1800 Exit"
+exit /b %ERRORLEVEL%
@@ -0,0 +1,15 @@
+#!/bin/sh
+# Headless climbing perf capture. Spawns a load in front of the player on <Map>, times 1800 frames of it, and exits with 1 if
+# the climbing ticks went over Climbing.Perf.BudgetP95, Climbing.Perf.BudgetP99 or Climbing.Perf.MaxAllocations.
+#
+#     RunClimbingPerfCapture.sh <UnrealEditor-Cmd|UE4Editor-Cmd> <TheElder.uproject> <Map>
+#
+# RunClimbingPerfCapture.bat does the same on Windows.
+
+if [ $# -lt 3 ]; then
+	echo "Usage: $0 <UnrealEditor-Cmd|UE4Editor-Cmd> <TheElder.uproject> <Map>" >&2
+	exit 2
+fi
+
+exec "$1" "$2" "$3" -game -nullrhi -unattended -nosplash -trace=cpu,bookmark \
+	-ExecCmds="Climbing.Perf.Spawn Climbables=2000 Ledges=200 Climbers=20, Climbing.Perf.Run 1800 Exit"
@@ -0,0 +1,156 @@
+/* Copyright 2019 Alexandrea Shackelford, Zion Nimchuk, All Rights Reserved.
+ * Unauthorized copying or modification of this file, via any medium is strictly prohibited.
+ */
+
+#include "ClimbRoutePlanner.h"
+#include "World/Climbable.h"
+#include "Algo/Reverse.h"
+
+void FClimbRoutePlanner::Start(AClimbable* StartClimbable, const FVector& StartLocation, AClimbable* InGoalClimbable,
+                               const FVector& InGoalLocation, float InGoalRadius, int32 InMaxNodes)
+{
+	Reset();
+
+	GoalClimbable = InGoalClimbable;
+	GoalLocation = InGoalClimbable != nullptr ? InGoalClimbable->GetActorLocation() : InGoalLocation;
+	GoalRadius = InGoalClimbable != nullptr ? 0.0f : InGoalRadius;
+	MaxNodes = InMaxNodes;
+
+	FNode StartNode;
+	StartNode.Climbable = StartClimbable;
+	StartNode.Location = StartClimbable != nullptr ? StartClimbable->GetActorLocation() : StartLocation;
+	Nodes.Add(StartNode);
+	if (StartClimbable != nullptr)
+	{
+		NodeLookup.Add(StartClimbable, 0);
+	}
+
+	OpenSet.HeapPush({0, GetHeuristic(StartNode.Location)}, FOpenEntryPredicate());
+	Status = EClimbRouteStatusEnum::CRS_Planning;
+}
+
+void FClimbRoutePlanner::Reset()
+{
+	Nodes.Reset();
+	NodeLookup.Reset();
+	OpenSet.Reset();
+	GoalClimbable = nullptr;
+	GoalNode = INDEX_NONE;
+	Status = EClimbRouteStatusEnum::CRS_None;
+}
+
+int32 FClimbRoutePlanner::Step(int32 MaxExpansions, FGatherNeighbours GatherNeighbours)
+{
+	int32 NumExpanded = 0;
+
+	while (Status == EClimbRouteStatusEnum::CRS_Planning && NumExpanded < MaxExpansions)
+	{
+		if (OpenSet.Num() == 0)
+		{
+			Status = EClimbRouteStatusEnum::CRS_Failed;
+			break;
+		}
+
+		FOpenEntry Entry;
+		OpenSet.HeapPop(Entry, FOpenEntryPredicate(), /*bAllowShrinking: */false);
+		if (Nodes[Entry.Node].bIsClosed)
+		{
+			continue;
+		}
+
+		Nodes[Entry.Node].bIsClosed = true;
+		NumExpanded++;
+
+		if (IsGoal(Nodes[Entry.Node]))
+		{
+			GoalNode = Entry.Node;
+			Status = EClimbRouteStatusEnum::CRS_Succeeded;
+			break;
+		}
+
+		// Copied out, since adding neighbours can move the node array around
+		auto Climbable = Nodes[Entry.Node].Climbable.Get();
+		const auto Location = Nodes[Entry.Node].Location;
+		const auto CostSoFar = Nodes[Entry.Node].CostSoFar;
+
+		// Something we already went through was destroyed, there's no getting anywhere from it any more
+		if (Climbable == nullptr && Entry.Node != 0)
+		{
+			continue;
+		}
+
+		NeighbourScratch.Reset();
+		GatherNeighbours(Climbable, Location, NeighbourScratch);
+
+		for (auto Neighbour : NeighbourScratch)
+		{
+			if (Neighbour == nullptr || Neighbour == Climbable)
+			{
+				continue;
+			}
+
+			const auto NeighbourLocation = Neighbour->GetActorLocation();
+			const auto NewCost = CostSoFar + FVector::Dist(Location, NeighbourLocation);
+
+			auto NeighbourNode = NodeLookup.Find(Neighbour);
+			if (NeighbourNode == nullptr)
+			{
+				// Past this point the search is costing more than the route would be worth
+				if (Nodes.Num() >= MaxNodes)
+				{
+					continue;
+				}
+
+				FNode NewNode;
+				NewNode.Climbable = Neighbour;
+				NewNode.Location = NeighbourLocation;
+				NewNode.CostSoFar = MAX_flt;
+				NeighbourNode = &NodeLookup.Add(Neighbour, Nodes.Add(NewNode));
+			}
+
+			auto& Node = Nodes[*NeighbourNode];
+			if (Node.bIsClosed || NewCost >= Node.CostSoFar)
+			{
+				continue;
+			}
+
+			Node.CostSoFar = NewCost;
+			Node.Parent = Entry.Node;
+			OpenSet.HeapPush({*NeighbourNode, NewCost + GetHeuristic(NeighbourLocation)}, FOpenEntryPredicate());
+		}
+	}
+
+	return NumExpanded;
+}
+
+void FClimbRoutePlanner::GetRoute(TArray<AClimbable*>& OutRoute) const
+{
+	OutRoute.Reset();
+	if (Status != EClimbRouteStatusEnum::CRS_Succeeded)
+	{
+		return;
+	}
+
+	// The start node is where we already are, so it's left out
+	for (auto Node = GoalNode; Node != INDEX_NONE && Node != 0; Node = Nodes[Node].Parent)
+	{
+		OutRoute.Add(Nodes[Node].Climbable.Get());
+	}
+	Algo::Reverse(OutRoute);
+}
+
+float FClimbRoutePlanner::GetHeuristic(const FVector& Location) const
+{
+	// Every jump costs its straight line distance, so this never overestimates
+	return FMath::Max(FVector::Dist(Location, GoalLocation) - GoalRadius, 0.0f);
+}
+
+bool FClimbRoutePlanner::IsGoal(const FNode& Node) const
+{
+	if (GoalClimbable.IsValid())
+	{
+		return Node.Climbable == GoalClimbable;
+	}
+
+	return FVector::DistSquared(Node.Location, GoalLocation) <= FMath::Square(GoalRadius);
+}
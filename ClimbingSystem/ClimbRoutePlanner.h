@@ -0,0 +1,92 @@
+/* Copyright 2019 Alexandrea Shackelford, Zion Nimchuk, All Rights Reserved.
+ * Unauthorized copying or modification of this file, via any medium is strictly prohibited.
+ */
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/Function.h"
+#include "ClimbRoutePlanner.generated.h"
+
+class AClimbable;
+
+UENUM(BlueprintType)
+enum class EClimbRouteStatusEnum : uint8
+{
+	CRS_None UMETA(DisplayName = "None"),
+	CRS_Planning UMETA(DisplayName = "Planning"),
+	CRS_Succeeded UMETA(DisplayName = "Succeeded"),
+	CRS_Failed UMETA(DisplayName = "Failed")
+};
+
+/**
+ * A* over which climbables can be jumped to from which, spread over as many frames as it needs. The planner doesn't know the
+ * climbing rules itself, whoever steps it hands in a function that gathers the climbables reachable from a node.
+ */
+class THEELDER_API FClimbRoutePlanner
+{
+public:
+
+	/* Fills OutNeighbours with where we can jump to from From, which is nullptr for the start when we're not on a climbable*/
+	using FGatherNeighbours = TFunctionRef<void(AClimbable* From, const FVector& FromLocation, TArray<AClimbable*>& OutNeighbours)>;
+
+	/**
+	 * \brief Throws away any search in progress and starts a new one
+	 * \param StartClimbable The climbable we're on, or nullptr if we're starting from StartLocation
+	 * \param GoalClimbable The climbable we want to get to, or nullptr to get within GoalRadius of GoalLocation
+	 * \param MaxNodes The search gives up once it's seen this many climbables
+	 */
+	void Start(AClimbable* StartClimbable, const FVector& StartLocation, AClimbable* GoalClimbable, const FVector& GoalLocation,
+		float GoalRadius, int32 MaxNodes);
+
+	void Reset();
+
+	/* Expands up to MaxExpansions climbables and returns how many were actually expanded*/
+	int32 Step(int32 MaxExpansions, FGatherNeighbours GatherNeighbours);
+
+	EClimbRouteStatusEnum GetStatus() const { return Status; }
+
+	/* The climbables to jump to in order, not including the one we started on. Only filled in once the search has succeeded.*/
+	void GetRoute(TArray<AClimbable*>& OutRoute) const;
+
+private:
+
+	struct FNode
+	{
+		TWeakObjectPtr<AClimbable> Climbable;
+		FVector Location = FVector::ZeroVector;
+		float CostSoFar = 0.0f;
+		int32 Parent = INDEX_NONE;
+		bool bIsClosed = false;
+	};
+
+	struct FOpenEntry
+	{
+		int32 Node;
+		float EstimatedCost;
+	};
+
+	struct FOpenEntryPredicate
+	{
+		FORCEINLINE bool operator()(const FOpenEntry& A, const FOpenEntry& B) const { return A.EstimatedCost < B.EstimatedCost; }
+	};
+
+	float GetHeuristic(const FVector& Location) const;
+	bool IsGoal(const FNode& Node) const;
+
+	TArray<FNode> Nodes;
+	TMap<const AActor*, int32> NodeLookup;
+
+	/* Heap on the estimated cost. Nodes that get a cheaper path are pushed again, the old entry gets skipped once it's closed.*/
+	TArray<FOpenEntry> OpenSet;
+
+	/* Kept around so stepping doesn't need to allocate once it's warmed up*/
+	TArray<AClimbable*> NeighbourScratch;
+
+	TWeakObjectPtr<AClimbable> GoalClimbable;
+	FVector GoalLocation = FVector::ZeroVector;
+	float GoalRadius = 0.0f;
+	int32 MaxNodes = 0;
+	int32 GoalNode = INDEX_NONE;
+
+	EClimbRouteStatusEnum Status = EClimbRouteStatusEnum::CRS_None;
+};
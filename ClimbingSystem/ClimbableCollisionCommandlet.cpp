@@ -0,0 +1,222 @@
+/* Copyright 2019 Alexandrea Shackelford, Zion Nimchuk, All Rights Reserved.
+ * Unauthorized copying or modification of this file, via any medium is strictly prohibited.
+ */
+
+#include "ClimbableCollisionCommandlet.h"
+#include "ClimbingCollision.h"
+#include "World/Climbable.h"
+#include "World/SplineLedge.h"
+#include "AssetRegistryModule.h"
+#include "Engine/Blueprint.h"
+#include "Engine/SCS_Node.h"
+#include "Engine/SimpleConstructionScript.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectGlobals.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogClimbableCollision, Log, All);
+
+UClimbableCollisionCommandlet::UClimbableCollisionCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UClimbableCollisionCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	ParseCommandLine(*Params, Tokens, Switches);
+	bSave = Switches.Contains(TEXT("Save"));
+
+	// The native defaults can't be fixed from here, they need to be set in the constructors
+	for (auto NativeClass : {AClimbable::StaticClass(), ASplineLedge::StaticClass()})
+	{
+		TInlineComponentArray<UPrimitiveComponent*> Primitives(NativeClass->GetDefaultObject<AActor>());
+		for (auto Primitive : Primitives)
+		{
+			if (Primitive->GetCollisionEnabled() != ECollisionEnabled::NoCollision && Primitive->GetCollisionObjectType() != ECC_Climbable)
+			{
+				UE_LOG(LogClimbableCollision, Warning, TEXT("%s's constructor gives %s a different object type than ECC_Climbable"),
+					*NativeClass->GetName(), *Primitive->GetName());
+				NumMisconfigured++;
+			}
+		}
+	}
+
+	auto& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.SearchAllAssets(/*bSynchronousSearch: */true);
+
+	// Blueprints first, so that the maps get loaded with the fixed up templates
+	TSet<FName> ClimbableClassNames;
+	AssetRegistry.GetDerivedClassNames({AClimbable::StaticClass()->GetFName()}, {}, ClimbableClassNames);
+
+	TArray<FAssetData> Blueprints;
+	AssetRegistry.GetAssetsByClass(UBlueprint::StaticClass()->GetFName(), Blueprints, /*bSearchSubClasses: */true);
+	for (const auto& AssetData : Blueprints)
+	{
+		FString GeneratedClassPath;
+		if (!AssetData.GetTagValue(FBlueprintTags::GeneratedClassPath, GeneratedClassPath) ||
+			!ClimbableClassNames.Contains(*FPackageName::ObjectPathToObjectName(FPackageName::ExportTextPathToObjectPath(GeneratedClassPath))))
+		{
+			continue;
+		}
+
+		auto Blueprint = Cast<UBlueprint>(AssetData.GetAsset());
+		if (Blueprint == nullptr || Blueprint->GeneratedClass == nullptr)
+		{
+			continue;
+		}
+
+		const auto Context = AssetData.PackageName.ToString();
+		bool bChanged = MigrateActor(Blueprint->GeneratedClass->GetDefaultObject<AActor>(), Context);
+
+		// Components added in the Blueprint only exist as templates on its construction script
+		if (Blueprint->SimpleConstructionScript != nullptr)
+		{
+			for (auto Node : Blueprint->SimpleConstructionScript->GetAllNodes())
+			{
+				if (auto Primitive = Cast<UPrimitiveComponent>(Node->ComponentTemplate))
+				{
+					bChanged |= MigrateComponent(Primitive, Context);
+				}
+			}
+		}
+
+		if (bChanged && !SavePackage(Blueprint->GetOutermost(), Blueprint, /*bIsMap: */false))
+		{
+			NumSaveFailures++;
+		}
+	}
+
+	TArray<FAssetData> Maps;
+	AssetRegistry.GetAssetsByClass(UWorld::StaticClass()->GetFName(), Maps);
+	for (const auto& AssetData : Maps)
+	{
+		const auto PackageName = AssetData.PackageName.ToString();
+		auto Package = LoadPackage(nullptr, *PackageName, LOAD_None);
+		auto World = Package != nullptr ? UWorld::FindWorldInPackage(Package) : nullptr;
+		if (World == nullptr || World->PersistentLevel == nullptr)
+		{
+			UE_LOG(LogClimbableCollision, Warning, TEXT("Couldn't load %s"), *PackageName);
+			continue;
+		}
+
+		bool bChanged = false;
+		for (auto Actor : World->PersistentLevel->Actors)
+		{
+			if (Actor != nullptr && Actor->IsA<AClimbable>())
+			{
+				bChanged |= MigrateActor(Actor, PackageName);
+			}
+		}
+
+		if (bChanged && !SavePackage(Package, World, /*bIsMap: */true))
+		{
+			NumSaveFailures++;
+		}
+
+		// Every map stays loaded otherwise
+		CollectGarbage(RF_NoFlags);
+	}
+
+	UE_LOG(LogClimbableCollision, Display, TEXT("%s %d components, %d climbables need fixing by hand"),
+		bSave ? TEXT("Migrated") : TEXT("Would migrate"), NumMigrated, NumMisconfigured);
+
+	if (NumSaveFailures > 0)
+	{
+		UE_LOG(LogClimbableCollision, Error, TEXT("%d packages couldn't be saved, the components in them weren't migrated"), NumSaveFailures);
+	}
+
+	return NumMisconfigured > 0 || NumSaveFailures > 0 ? 1 : 0;
+#else
+	return 1;
+#endif
+}
+
+bool UClimbableCollisionCommandlet::MigrateActor(AActor* Actor, const FString& Context)
+{
+	bool bChanged = false;
+	bool bHasCollision = false;
+
+	TInlineComponentArray<UPrimitiveComponent*> Primitives(Actor);
+	for (auto Primitive : Primitives)
+	{
+		bHasCollision |= Primitive->GetCollisionEnabled() != ECollisionEnabled::NoCollision;
+		bChanged |= MigrateComponent(Primitive, Context);
+	}
+
+	// Blueprint defaults might leave collision for the construction script to add, which MigrateComponent is given separately
+	if (!bHasCollision && !Actor->HasAnyFlags(RF_ClassDefaultObject))
+	{
+		UE_LOG(LogClimbableCollision, Warning, TEXT("%s: %s has no collision, the climbable index will only see its root"),
+			*Context, *Actor->GetName());
+		NumMisconfigured++;
+	}
+
+	return bChanged;
+}
+
+bool UClimbableCollisionCommandlet::MigrateComponent(UPrimitiveComponent* Primitive, const FString& Context)
+{
+	// Purely visual components don't matter to climbing
+	if (Primitive->GetCollisionEnabled() == ECollisionEnabled::NoCollision)
+	{
+		return false;
+	}
+
+	const auto ObjectType = Primitive->GetCollisionObjectType();
+	if (ObjectType == ECC_Climbable)
+	{
+		return false;
+	}
+
+	// Anything other than the old defaults was most likely set on purpose, so leave it for someone to look at
+	if (ObjectType != ECC_WorldStatic && ObjectType != ECC_WorldDynamic)
+	{
+		UE_LOG(LogClimbableCollision, Warning, TEXT("%s: %s.%s has object type %d, expected WorldStatic or WorldDynamic"),
+			*Context, *GetNameSafe(Primitive->GetOwner()), *Primitive->GetName(), static_cast<int32>(ObjectType));
+		NumMisconfigured++;
+		return false;
+	}
+
+	UE_LOG(LogClimbableCollision, Display, TEXT("%s: %s.%s"), *Context, *GetNameSafe(Primitive->GetOwner()), *Primitive->GetName());
+	NumMigrated++;
+
+	if (bSave)
+	{
+		// Only the object type changes, every response stays the same
+		Primitive->Modify();
+		Primitive->SetCollisionObjectType(ECC_Climbable);
+	}
+	return true;
+}
+
+bool UClimbableCollisionCommandlet::SavePackage(UPackage* Package, UObject* Asset, bool bIsMap) const
+{
+	if (!bSave)
+	{
+		return true;
+	}
+
+	const auto Filename = FPackageName::LongPackageNameToFilename(Package->GetName(),
+		bIsMap ? FPackageName::GetMapPackageExtension() : FPackageName::GetAssetPackageExtension());
+
+	if (IFileManager::Get().IsReadOnly(*Filename))
+	{
+		UE_LOG(LogClimbableCollision, Error, TEXT("%s is read only, check it out and run again"), *Filename);
+		return false;
+	}
+
+	if (!UPackage::SavePackage(Package, Asset, RF_Standalone, *Filename))
+	{
+		UE_LOG(LogClimbableCollision, Error, TEXT("Couldn't save %s"), *Filename);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,49 @@
+/* Copyright 2019 Alexandrea Shackelford, Zion Nimchuk, All Rights Reserved.
+ * Unauthorized copying or modification of this file, via any medium is strictly prohibited.
+ */
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ClimbableCollisionCommandlet.generated.h"
+
+class AActor;
+class UPrimitiveComponent;
+
+/**
+ * Moves the collision on every AClimbable and ASplineLedge in the project's maps and Blueprints over to the Climbable object type,
+ * and reports any climbable that's set up in a way the climbing component can't use. Only reports unless -Save is passed.
+ *
+ *     UE4Editor-Cmd.exe TheElder.uproject -run=ClimbableCollision [-Save]
+ */
+UCLASS()
+class UClimbableCollisionCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UClimbableCollisionCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+
+	/* Without -Save nothing gets changed, it only reports what would be*/
+	bool bSave = false;
+
+	int32 NumMigrated = 0;
+	int32 NumMisconfigured = 0;
+
+	/* Packages that had changes but couldn't be written, whatever was migrated in them wasn't really*/
+	int32 NumSaveFailures = 0;
+
+	/* Returns true if anything on the actor was changed*/
+	bool MigrateActor(AActor* Actor, const FString& Context);
+
+	/* Returns true if the component was changed*/
+	bool MigrateComponent(UPrimitiveComponent* Primitive, const FString& Context);
+
+	/* Saves the package if -Save was passed, returns false if it couldn't be written*/
+	bool SavePackage(UPackage* Package, UObject* Asset, bool bIsMap) const;
+};
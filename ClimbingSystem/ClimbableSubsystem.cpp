@@ -0,0 +1,1675 @@
+/* Copyright 2019 Alexandrea Shackelford, Zion Nimchuk, All Rights Reserved.
+ * Unauthorized copying or modification of this file, via any medium is strictly prohibited.
+ */
+
+#include "ClimbableSubsystem.h"
+#include "World/Climbable.h"
+#include "World/SplineLedge.h"
+#include "ClimbingGraph.h"
+#include "Engine/World.h"
+#include "Engine/Level.h"
+#include "EngineUtils.h"
+#include "Components/SplineComponent.h"
+#include "Components/SphereComponent.h"
+#include "Curves/CurveFloat.h"
+#include "ClimbingComponent.h"
+#include "ClimbingCollision.h"
+#include "ClimbingCore.h"
+#include "HAL/IConsoleManager.h"
+#include "ClimbingStats.h"
+#include "ClimbingPerf.h"
+#include "Async/ParallelFor.h"
+#include "Misc/ScopeExit.h"
+
+static TAutoConsoleVariable<int32> CVarClimbingUseSampledLedges(
+	TEXT("Climbing.UseSampledLedges"),
+	0,
+	TEXT("When on, ledge climb up transforms are looked up in a table sampled along the spline at BeginPlay, ")
+	TEXT("instead of projecting onto the spline every time."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarClimbingProximityWakeDistance(
+	TEXT("Climbing.ProximityWakeDistance"),
+	3000.0f,
+	TEXT("How far from a cluster of climbables a climbing component with adaptive ticking goes to sleep. ")
+	TEXT("Only read when the proximity volumes are built at BeginPlay."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarClimbingMovingClimbableSettleTime(
+	TEXT("Climbing.MovingClimbableSettleTime"),
+	2.0f,
+	TEXT("How many seconds a climbable has to stay put after its bIsMoving is cleared before it's indexed like any other static climbable."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarClimbingRoutePlanningBudget(
+	TEXT("Climbing.RoutePlanningBudget"),
+	256,
+	TEXT("How many climbables route planning can expand per frame, split between every climbing component that's planning."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarClimbingObstructionCacheLifetime(
+	TEXT("Climbing.ObstructionCacheLifetime"),
+	5.0f,
+	TEXT("How many seconds a cached obstruction check is trusted for, in case something got in the way without moving, like collision ")
+	TEXT("being switched on. 0 turns the cache off."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarClimbingParallelBatchedTick(
+	TEXT("Climbing.ParallelBatchedTick"),
+	1,
+	TEXT("When on, the batched climbing tick works out every climber on worker threads. ")
+	TEXT("Turning it off runs the same batches one after another on the game thread, which is easier to step through."),
+	ECVF_Default);
+
+void FClimbingBatchedTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread,
+                                               const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Subsystem != nullptr)
+	{
+		Subsystem->TickQueuedClimbers();
+	}
+}
+
+FString FClimbingBatchedTickFunction::DiagnosticMessage()
+{
+	return TEXT("FClimbingBatchedTickFunction");
+}
+
+void FClimbableMirror::SetNum(int32 NewNum)
+{
+	PositionX.SetNumZeroed(NewNum);
+	PositionY.SetNumZeroed(NewNum);
+	PositionZ.SetNumZeroed(NewNum);
+	Yaw.SetNumZeroed(NewNum);
+	Pitch.SetNumZeroed(NewNum);
+	Flags.SetNumZeroed(NewNum);
+}
+
+void FClimbableMirror::Write(int32 Slot, const AClimbable* Climbable, bool bIsMoving)
+{
+	const auto Location = Climbable->GetActorLocation();
+	const auto Rotation = Climbable->GetActorRotation();
+
+	PositionX[Slot] = Location.X;
+	PositionY[Slot] = Location.Y;
+	PositionZ[Slot] = Location.Z;
+	Yaw[Slot] = Rotation.Yaw;
+	Pitch[Slot] = Rotation.Pitch;
+
+	uint8 NewFlags = 0;
+	if (Cast<ASplineLedge>(Climbable) != nullptr)
+	{
+		NewFlags |= CMF_IsLedge;
+	}
+	if (bIsMoving)
+	{
+		NewFlags |= CMF_IsMoving;
+	}
+	Flags[Slot] = NewFlags;
+}
+
+void FClimbableMirror::Clear(int32 Slot)
+{
+	PositionX[Slot] = PositionY[Slot] = PositionZ[Slot] = 0.0f;
+	Yaw[Slot] = Pitch[Slot] = 0.0f;
+	Flags[Slot] = 0;
+}
+
+void FClimbingCurveTable::Build(const UCurveFloat* Curve)
+{
+	Curve->GetTimeRange(MinTime, MaxTime);
+
+	Samples.SetNumUninitialized(NumSamples);
+	for (int32 i = 0; i < NumSamples; i++)
+	{
+		Samples[i] = Curve->GetFloatValue(FMath::Lerp(MinTime, MaxTime, static_cast<float>(i) / (NumSamples - 1)));
+	}
+}
+
+float FClimbingCurveTable::Evaluate(float Time) const
+{
+	return ClimbingCore::SampleUniformTable(Samples.GetData(), Samples.Num(), MinTime, MaxTime, Time);
+}
+
+void UClimbableSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	auto World = GetWorld();
+	if (World == nullptr)
+	{
+		return;
+	}
+
+	ActorSpawnedHandle = World->AddOnActorSpawnedHandler(
+		FOnActorSpawned::FDelegate::CreateUObject(this, &UClimbableSubsystem::OnActorSpawned));
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UClimbableSubsystem::OnLevelAdded);
+	LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &UClimbableSubsystem::OnLevelRemoved);
+
+	GameThreadQueryContext.LedgeMemos.Reserve(ReservedLedgeMemos);
+}
+
+void UClimbableSubsystem::Deinitialize()
+{
+	auto World = GetWorld();
+	if (World != nullptr)
+	{
+		World->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	}
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+
+	for (const auto& Pair : WatchedObstacles)
+	{
+		if (auto Primitive = Pair.Key.Get())
+		{
+			Primitive->TransformUpdated.RemoveAll(this);
+		}
+	}
+	WatchedObstacles.Empty();
+	CachedObstructions.Empty();
+	ObstructionCells.Empty();
+
+	for (const auto& Entry : Entries)
+	{
+		if (auto Root = Entry.WatchedRoot.Get())
+		{
+			Root->TransformUpdated.Remove(Entry.TransformUpdatedHandle);
+		}
+	}
+	Entries.Empty();
+	FreeEntries.Empty();
+	EntryLookup.Empty();
+	Cells.Empty();
+	MovingEntries.Empty();
+	LedgeTables.Empty();
+	CurveTables.Empty();
+	BakedNodes.Empty();
+	GameThreadQueryContext = FQueryContext();
+	WorkerQueryContexts.Empty();
+
+	if (BatchedTickFunction.IsTickFunctionRegistered())
+	{
+		BatchedTickFunction.UnRegisterTickFunction();
+	}
+	QueuedClimbingTicks.Empty();
+	ComputingClimbers.Empty();
+
+	// When the whole world is going away it cleans the owner up along with everything else, destroying it then just trips over the teardown
+	if (ProximityVolumeOwner != nullptr && !ProximityVolumeOwner->IsPendingKill() && World != nullptr && !World->bIsTearingDown)
+	{
+		ProximityVolumeOwner->Destroy();
+	}
+	ProximityVolumeOwner = nullptr;
+	ProximityVolumes.Empty();
+
+	Super::Deinitialize();
+}
+
+void UClimbableSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// Anything placed in the level has already been loaded by now, so just pick it all up in one go
+	for (TActorIterator<AClimbable> It(&InWorld); It; ++It)
+	{
+		RegisterClimbable(*It);
+	}
+
+	for (TActorIterator<AClimbingGraph> It(&InWorld); It; ++It)
+	{
+		RegisterClimbingGraph(*It);
+	}
+
+	for (TActorIterator<AActor> It(&InWorld); It; ++It)
+	{
+		WatchObstacle(*It);
+	}
+
+	BuildProximityVolumes();
+
+	// Climbing components tick during physics by default, going after them is what lets everyone's tick be done at once
+	BatchedTickFunction.Subsystem = this;
+	BatchedTickFunction.bCanEverTick = true;
+	BatchedTickFunction.TickGroup = TG_PostPhysics;
+	BatchedTickFunction.RegisterTickFunction(InWorld.PersistentLevel);
+}
+
+void UClimbableSubsystem::RegisterClimbable(AClimbable* Climbable)
+{
+	if (Climbable == nullptr || Climbable->IsPendingKill() || EntryLookup.Contains(Climbable))
+	{
+		return;
+	}
+
+	int32 EntryIndex;
+	if (FreeEntries.Num() > 0)
+	{
+		EntryIndex = FreeEntries.Pop(/*bAllowShrinking: */false);
+		Entries[EntryIndex] = FClimbableEntry();
+	}
+	else
+	{
+		EntryIndex = Entries.AddDefaulted();
+		Mirror.SetNum(Entries.Num());
+	}
+
+	auto& Entry = Entries[EntryIndex];
+	Entry.Climbable = Climbable;
+	Entry.bIsMoving = Climbable->bIsMoving;
+	RefreshEntryBounds(Entry);
+	Mirror.Write(EntryIndex, Climbable, Entry.bIsMoving);
+
+	// Anything that can move might do it without bIsMoving being set, or start again after it's settled
+	auto Root = Climbable->GetRootComponent();
+	if (Root != nullptr && Root->Mobility == EComponentMobility::Movable)
+	{
+		Entry.WatchedRoot = Root;
+		Entry.TransformUpdatedHandle = Root->TransformUpdated.AddUObject(this, &UClimbableSubsystem::OnClimbableMoved);
+	}
+
+	EntryLookup.Add(Climbable, EntryIndex);
+	Generation++;
+	AddToCells(EntryIndex);
+
+	if (Entry.bIsMoving)
+	{
+		MovingEntries.Add(EntryIndex);
+	}
+
+	if (auto Ledge = Cast<ASplineLedge>(Climbable))
+	{
+		BuildLedgeTable(Ledge);
+	}
+
+	// Anything registered at BeginPlay gets picked up when the volumes are built
+	if (ProximityVolumeOwner != nullptr)
+	{
+		AddProximityVolumeFor(Climbable);
+	}
+
+	Climbable->OnEndPlay.AddUniqueDynamic(this, &UClimbableSubsystem::OnClimbableEndPlay);
+}
+
+void UClimbableSubsystem::UnregisterClimbable(AClimbable* Climbable)
+{
+	int32 EntryIndex;
+	if (!EntryLookup.RemoveAndCopyValue(Climbable, EntryIndex))
+	{
+		return;
+	}
+
+	RemoveFromCells(EntryIndex);
+	MovingEntries.RemoveSwap(EntryIndex);
+	if (auto Root = Entries[EntryIndex].WatchedRoot.Get())
+	{
+		Root->TransformUpdated.Remove(Entries[EntryIndex].TransformUpdatedHandle);
+	}
+	Entries[EntryIndex] = FClimbableEntry();
+	Mirror.Clear(EntryIndex);
+	LedgeTables.Remove(Climbable);
+	RemoveCachedObstruction(Climbable);
+	FreeEntries.Add(EntryIndex);
+	Generation++;
+
+	if (Climbable != nullptr)
+	{
+		Climbable->OnEndPlay.RemoveDynamic(this, &UClimbableSubsystem::OnClimbableEndPlay);
+	}
+
+	OnClimbableUnregistered.Broadcast(Climbable);
+}
+
+void UClimbableSubsystem::UpdateClimbable(AClimbable* Climbable)
+{
+	auto EntryIndex = EntryLookup.Find(Climbable);
+	if (EntryIndex == nullptr)
+	{
+		return;
+	}
+
+	MarkMoving(*EntryIndex);
+
+	auto& Entry = Entries[*EntryIndex];
+	const auto OldMinCell = Entry.MinCell;
+	const auto OldMaxCell = Entry.MaxCell;
+
+	RefreshEntryBounds(Entry);
+	Mirror.Write(*EntryIndex, Climbable, Entry.bIsMoving);
+
+	// Most of the time a moving climbable is still inside the same cells, so don't touch the hash
+	if (Entry.MinCell != OldMinCell || Entry.MaxCell != OldMaxCell)
+	{
+		const auto NewMinCell = Entry.MinCell;
+		const auto NewMaxCell = Entry.MaxCell;
+		Entry.MinCell = OldMinCell;
+		Entry.MaxCell = OldMaxCell;
+		RemoveFromCells(*EntryIndex);
+		Entry.MinCell = NewMinCell;
+		Entry.MaxCell = NewMaxCell;
+		AddToCells(*EntryIndex);
+	}
+}
+
+bool UClimbableSubsystem::QuerySphere(const FVector& Center, float Radius, TArrayView<AActor* const> IgnoreList,
+                                      TArray<AClimbable*>& OutClimbables, TArray<int32>* OutSlots,
+                                      TArray<FBox>* OutBounds)
+{
+	const auto RadiusSquared = FMath::Square(Radius);
+	return QueryBox(FBox::BuildAABB(Center, FVector(Radius)), IgnoreList, OutClimbables, OutSlots, OutBounds,
+		[&](const FBox& Bounds)
+		{
+			return Bounds.ComputeSquaredDistanceToPoint(Center) <= RadiusSquared;
+		});
+}
+
+bool UClimbableSubsystem::QuerySphereShared(const FVector& Center, float Radius, TArrayView<AActor* const> IgnoreList,
+                                            TArray<AClimbable*>& OutClimbables, TArray<int32>* OutSlots, TArray<FBox>* OutBounds)
+{
+	auto& Context = GetQueryContext();
+	if (Context.SharedQueryFrame != GFrameCounter)
+	{
+		Context.SharedQueryFrame = GFrameCounter;
+		Context.NumSharedQueryRegions = 0;
+	}
+
+	FSharedQueryRegion* Region = nullptr;
+	for (int32 i = 0; i < Context.NumSharedQueryRegions; i++)
+	{
+		auto& Candidate = Context.SharedQueryRegions[i];
+		if (FVector::Dist(Candidate.Center, Center) + Radius <= Candidate.Radius)
+		{
+			Region = &Candidate;
+			break;
+		}
+	}
+
+	// Nobody has asked about this area yet, so do the query for everyone. The regions are reused between frames to keep their memory.
+	if (Region == nullptr)
+	{
+		if (Context.NumSharedQueryRegions == Context.SharedQueryRegions.Num())
+		{
+			Context.SharedQueryRegions.AddDefaulted();
+		}
+		Region = &Context.SharedQueryRegions[Context.NumSharedQueryRegions++];
+		Region->Center = Center;
+		Region->Radius = Radius + SharedQueryPadding;
+
+		INC_DWORD_STAT(STAT_Climbing_SharedQueryMisses);
+
+		QuerySphere(Region->Center, Region->Radius, TArrayView<AActor* const>(), Region->Climbables, &Region->Slots, &Region->Bounds);
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_Climbing_SharedQueryHits);
+	}
+
+	OutClimbables.Reset();
+	if (OutSlots != nullptr)
+	{
+		OutSlots->Reset();
+	}
+	if (OutBounds != nullptr)
+	{
+		OutBounds->Reset();
+	}
+
+	const auto RadiusSquared = FMath::Square(Radius);
+	for (int32 i = 0; i < Region->Climbables.Num(); i++)
+	{
+		auto Climbable = Region->Climbables[i];
+		if (Region->Bounds[i].ComputeSquaredDistanceToPoint(Center) > RadiusSquared || IgnoreList.Contains(Climbable))
+		{
+			continue;
+		}
+
+		OutClimbables.Add(Climbable);
+		if (OutSlots != nullptr)
+		{
+			OutSlots->Add(Region->Slots[i]);
+		}
+		if (OutBounds != nullptr)
+		{
+			OutBounds->Add(Region->Bounds[i]);
+		}
+	}
+
+	return OutClimbables.Num() > 0;
+}
+
+bool UClimbableSubsystem::QueryCapsule(const FVector& Center, float Radius, float HalfHeight,
+                                       TArrayView<AActor* const> IgnoreList, TArray<AClimbable*>& OutClimbables,
+                                       TArray<int32>* OutSlots, TArray<FBox>* OutBounds)
+{
+	const auto RadiusSquared = FMath::Square(Radius);
+	const auto SegmentHalfLength = FMath::Max(HalfHeight - Radius, 0.0f);
+	const auto SegmentMinZ = Center.Z - SegmentHalfLength;
+	const auto SegmentMaxZ = Center.Z + SegmentHalfLength;
+
+	return QueryBox(FBox::BuildAABB(Center, FVector(Radius, Radius, FMath::Max(HalfHeight, Radius))), IgnoreList, OutClimbables, OutSlots, OutBounds,
+		[&](const FBox& Bounds)
+		{
+			// The capsule is always upright, so the closest point on its segment is just a clamp on Z
+			const auto DeltaX = FMath::Max3(Bounds.Min.X - Center.X, 0.0f, Center.X - Bounds.Max.X);
+			const auto DeltaY = FMath::Max3(Bounds.Min.Y - Center.Y, 0.0f, Center.Y - Bounds.Max.Y);
+			const auto DeltaZ = FMath::Max3(Bounds.Min.Z - SegmentMaxZ, 0.0f, SegmentMinZ - Bounds.Max.Z);
+			return DeltaX * DeltaX + DeltaY * DeltaY + DeltaZ * DeltaZ <= RadiusSquared;
+		});
+}
+
+bool UClimbableSubsystem::QueryPath(TArrayView<const FVector> Points, float Radius, float HalfHeight,
+                                    TArrayView<AActor* const> IgnoreList, TArray<AClimbable*>& OutClimbables,
+                                    TArray<int32>* OutSlots, TArray<FBox>* OutBounds)
+{
+	const FVector Extent(Radius, Radius, FMath::Max(HalfHeight, Radius));
+	FBox QueryBounds(ForceInit);
+	for (const auto& Point : Points)
+	{
+		QueryBounds += FBox::BuildAABB(Point, Extent);
+	}
+
+	return QueryBox(QueryBounds, IgnoreList, OutClimbables, OutSlots, OutBounds,
+		[&](const FBox& Bounds)
+		{
+			for (int32 i = 1; i < Points.Num(); i++)
+			{
+				if (DoesSweptCapsuleTouchBox(Bounds, Points[i - 1], Points[i], Radius, HalfHeight))
+				{
+					return true;
+				}
+			}
+			return false;
+		});
+}
+
+bool UClimbableSubsystem::DoesSweptCapsuleTouchBox(const FBox& Bounds, const FVector& Start, const FVector& End, float Radius,
+                                                   float HalfHeight)
+{
+	// Grow the box by the capsule's extent instead, then it's just the segment against the grown box
+	const auto Expanded = Bounds.ExpandBy(FVector(Radius, Radius, FMath::Max(HalfHeight, Radius)));
+	if (Expanded.IsInsideOrOn(Start) || Expanded.IsInsideOrOn(End))
+	{
+		return true;
+	}
+
+	if (Start.Equals(End))
+	{
+		return false;
+	}
+
+	return FMath::LineBoxIntersection(Expanded, Start, End, End - Start);
+}
+
+template <typename OverlapFunc>
+bool UClimbableSubsystem::QueryBox(const FBox& QueryBounds, TArrayView<AActor* const> IgnoreList,
+                                   TArray<AClimbable*>& OutClimbables, TArray<int32>* OutSlots, TArray<FBox>* OutBounds,
+                                   OverlapFunc&& Overlaps)
+{
+	CLIMBING_SCOPE_CYCLE_COUNTER(STAT_Climbing_IndexQuery);
+
+	OutClimbables.Reset();
+	if (OutSlots != nullptr)
+	{
+		OutSlots->Reset();
+	}
+	if (OutBounds != nullptr)
+	{
+		OutBounds->Reset();
+	}
+	RefreshMovingClimbables();
+
+	// Entries only ever grow on the game thread, so a worker's stamps are sized before it gets its context
+	auto& Context = GetQueryContext();
+	if (Context.EntryStamps.Num() < Entries.Num())
+	{
+		Context.EntryStamps.SetNumZeroed(Entries.Num());
+	}
+	Context.QueryStamp++;
+
+	const auto MinCell = GetCell(QueryBounds.Min);
+	const auto MaxCell = GetCell(QueryBounds.Max);
+
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++)
+			{
+				auto Cell = Cells.Find(FIntVector(X, Y, Z));
+				if (Cell == nullptr)
+				{
+					continue;
+				}
+
+				for (auto EntryIndex : *Cell)
+				{
+					auto& Stamp = Context.EntryStamps[EntryIndex];
+					if (Stamp == Context.QueryStamp)
+					{
+						continue;
+					}
+					Stamp = Context.QueryStamp;
+
+					const auto& Entry = Entries[EntryIndex];
+					auto Climbable = Entry.Climbable.Get();
+					if (Climbable == nullptr || IgnoreList.Contains(Climbable))
+					{
+						continue;
+					}
+
+					if (Overlaps(Entry.Bounds))
+					{
+						OutClimbables.Add(Climbable);
+						if (OutSlots != nullptr)
+						{
+							OutSlots->Add(EntryIndex);
+						}
+						if (OutBounds != nullptr)
+						{
+							OutBounds->Add(Entry.Bounds);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	return OutClimbables.Num() > 0;
+}
+
+FTransform UClimbableSubsystem::GetClimbUpTransform(const ASplineLedge* Ledge, AActor* QueryingActor)
+{
+	CLIMBING_SCOPE_CYCLE_COUNTER(STAT_Climbing_LedgeClimbUpTransform);
+
+	auto& Context = GetQueryContext();
+	ResetStaleLedgeMemos(Context);
+
+	// The actor can still move during the frame, like when we snap to the hanging position, so the memo has to match its location too
+	const auto QueryLocation = QueryingActor->GetActorLocation();
+	auto& Memo = Context.LedgeMemos.FindOrAdd(TPair<const AActor*, const AActor*>(Ledge, QueryingActor));
+	if (Memo.bIsValid && Memo.QueryLocation == QueryLocation)
+	{
+		INC_DWORD_STAT(STAT_Climbing_LedgeMemoHits);
+		return Memo.Transform;
+	}
+
+	INC_DWORD_STAT(STAT_Climbing_LedgeMemoMisses);
+
+	auto Table = CVarClimbingUseSampledLedges.GetValueOnAnyThread() != 0 ? LedgeTables.Find(Ledge) : nullptr;
+	if (Table != nullptr)
+	{
+		Memo.Transform = FindClosestLedgeSample(*Table, Ledge->GetActorTransform(), QueryLocation);
+	}
+	else
+	{
+		Memo.Transform = Ledge->GetClimbUpTransform(QueryingActor);
+	}
+	Memo.QueryLocation = QueryLocation;
+	Memo.bIsValid = true;
+
+	return Memo.Transform;
+}
+
+void UClimbableSubsystem::ResetStaleLedgeMemos(FQueryContext& Context)
+{
+	if (Context.LedgeMemoFrame != GFrameCounter)
+	{
+		Context.LedgeMemoFrame = GFrameCounter;
+		// Reset keeps the memory, so this only allocates the first time a frame needs more than we reserved
+		Context.LedgeMemos.Reset();
+	}
+}
+
+void UClimbableSubsystem::BuildLedgeTable(const ASplineLedge* Ledge)
+{
+	auto Spline = Ledge->FindComponentByClass<USplineComponent>();
+	if (Spline == nullptr)
+	{
+		return;
+	}
+
+	const auto SplineLength = Spline->GetSplineLength();
+	const auto NumSamples = FMath::Clamp(FMath::CeilToInt(SplineLength / LedgeSampleSpacing) + 1, 2, MaxLedgeSamples);
+	const auto LedgeTransform = Ledge->GetActorTransform();
+
+	auto& Table = LedgeTables.FindOrAdd(Ledge);
+	Table.X.SetNumUninitialized(NumSamples);
+	Table.Y.SetNumUninitialized(NumSamples);
+	Table.Z.SetNumUninitialized(NumSamples);
+	Table.Rotations.SetNumUninitialized(NumSamples);
+
+	for (int32 i = 0; i < NumSamples; i++)
+	{
+		const auto Distance = SplineLength * i / (NumSamples - 1);
+		const auto SampleTransform = Spline->GetTransformAtDistanceAlongSpline(Distance, ESplineCoordinateSpace::World)
+			.GetRelativeTransform(LedgeTransform);
+
+		const auto Location = SampleTransform.GetLocation();
+		Table.X[i] = Location.X;
+		Table.Y[i] = Location.Y;
+		Table.Z[i] = Location.Z;
+		Table.Rotations[i] = SampleTransform.GetRotation();
+	}
+}
+
+FTransform UClimbableSubsystem::FindClosestLedgeSample(const FLedgeSampleTable& Table, const FTransform& LedgeTransform,
+                                                       const FVector& WorldLocation) const
+{
+	const auto Point = LedgeTransform.InverseTransformPosition(WorldLocation);
+
+	// Project onto every segment between samples and keep the closest, this is a straight scan over a few hundred floats at most
+	int32 BestSegment = 0;
+	float BestAlpha = 0.0f;
+	float BestDistanceSquared = MAX_flt;
+
+	for (int32 i = 0; i < Table.X.Num() - 1; i++)
+	{
+		const auto SegmentX = Table.X[i + 1] - Table.X[i];
+		const auto SegmentY = Table.Y[i + 1] - Table.Y[i];
+		const auto SegmentZ = Table.Z[i + 1] - Table.Z[i];
+		const auto ToPointX = Point.X - Table.X[i];
+		const auto ToPointY = Point.Y - Table.Y[i];
+		const auto ToPointZ = Point.Z - Table.Z[i];
+
+		const auto SegmentLengthSquared = SegmentX * SegmentX + SegmentY * SegmentY + SegmentZ * SegmentZ;
+		const auto Alpha = SegmentLengthSquared > SMALL_NUMBER
+			? FMath::Clamp((ToPointX * SegmentX + ToPointY * SegmentY + ToPointZ * SegmentZ) / SegmentLengthSquared, 0.0f, 1.0f)
+			: 0.0f;
+
+		const auto DeltaX = ToPointX - SegmentX * Alpha;
+		const auto DeltaY = ToPointY - SegmentY * Alpha;
+		const auto DeltaZ = ToPointZ - SegmentZ * Alpha;
+		const auto DistanceSquared = DeltaX * DeltaX + DeltaY * DeltaY + DeltaZ * DeltaZ;
+
+		if (DistanceSquared < BestDistanceSquared)
+		{
+			BestDistanceSquared = DistanceSquared;
+			BestSegment = i;
+			BestAlpha = Alpha;
+		}
+	}
+
+	const auto Start = FVector(Table.X[BestSegment], Table.Y[BestSegment], Table.Z[BestSegment]);
+	const auto End = FVector(Table.X[BestSegment + 1], Table.Y[BestSegment + 1], Table.Z[BestSegment + 1]);
+	const FTransform LocalTransform(
+		FQuat::Slerp(Table.Rotations[BestSegment], Table.Rotations[BestSegment + 1], BestAlpha),
+		FMath::Lerp(Start, End, BestAlpha));
+
+	return LocalTransform * LedgeTransform;
+}
+
+bool UClimbableSubsystem::IsInsideProximityVolume(const FVector& Location) const
+{
+	for (auto Volume : ProximityVolumes)
+	{
+		if (Volume != nullptr &&
+			FVector::DistSquared(Volume->GetComponentLocation(), Location) <= FMath::Square(Volume->GetScaledSphereRadius()))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void UClimbableSubsystem::BuildProximityVolumes()
+{
+	auto World = GetWorld();
+	if (World == nullptr || ProximityVolumeOwner != nullptr)
+	{
+		return;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	ProximityVolumeOwner = World->SpawnActor<AActor>(SpawnParams);
+	if (ProximityVolumeOwner == nullptr)
+	{
+		return;
+	}
+
+	ProximityVolumeOwner->SetRootComponent(NewObject<USceneComponent>(ProximityVolumeOwner, TEXT("Root")));
+	ProximityVolumeOwner->GetRootComponent()->RegisterComponent();
+
+	// Static climbables get lumped together by which coarse cell they're in
+	TMap<FIntVector, FBox> Clusters;
+	for (const auto& Entry : Entries)
+	{
+		auto Climbable = Entry.Climbable.Get();
+		if (Climbable == nullptr)
+		{
+			continue;
+		}
+
+		if (Entry.bIsMoving)
+		{
+			AddProximityVolumeFor(Climbable);
+			continue;
+		}
+
+		const auto Center = Entry.Bounds.GetCenter();
+		const FIntVector ClusterKey(
+			FMath::FloorToInt(Center.X / ProximityClusterSize),
+			FMath::FloorToInt(Center.Y / ProximityClusterSize),
+			FMath::FloorToInt(Center.Z / ProximityClusterSize));
+		Clusters.FindOrAdd(ClusterKey, FBox(ForceInit)) += Entry.Bounds;
+	}
+
+	const auto WakeDistance = CVarClimbingProximityWakeDistance.GetValueOnGameThread();
+	for (const auto& Cluster : Clusters)
+	{
+		CreateProximityVolume(Cluster.Value.GetCenter(), Cluster.Value.GetExtent().Size() + WakeDistance);
+	}
+}
+
+void UClimbableSubsystem::AddProximityVolumeFor(const AClimbable* Climbable)
+{
+	auto EntryIndex = EntryLookup.Find(Climbable);
+	if (EntryIndex == nullptr)
+	{
+		return;
+	}
+
+	const auto& Entry = Entries[*EntryIndex];
+	const auto Center = Entry.Bounds.GetCenter();
+	const auto Radius = Entry.Bounds.GetExtent().Size() + CVarClimbingProximityWakeDistance.GetValueOnGameThread();
+
+	if (!Entry.bIsMoving)
+	{
+		// It might already be covered by one of the clusters
+		for (auto Volume : ProximityVolumes)
+		{
+			if (Volume != nullptr && Volume->GetAttachParent() == ProximityVolumeOwner->GetRootComponent() &&
+				FVector::Dist(Volume->GetComponentLocation(), Center) + Radius <= Volume->GetScaledSphereRadius())
+			{
+				return;
+			}
+		}
+	}
+
+	auto Volume = CreateProximityVolume(Center, Radius);
+	if (Volume != nullptr && Entry.bIsMoving)
+	{
+		// Moving climbables, like the boss, take their volume with them
+		Volume->AttachToComponent(Climbable->GetRootComponent(), FAttachmentTransformRules::KeepWorldTransform);
+	}
+}
+
+USphereComponent* UClimbableSubsystem::CreateProximityVolume(const FVector& Center, float Radius)
+{
+	if (ProximityVolumeOwner == nullptr)
+	{
+		return nullptr;
+	}
+
+	auto Volume = NewObject<USphereComponent>(ProximityVolumeOwner);
+	Volume->SetupAttachment(ProximityVolumeOwner->GetRootComponent());
+	Volume->SetWorldLocation(Center);
+	Volume->SetSphereRadius(Radius, /*bUpdateOverlaps: */false);
+	Volume->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+	Volume->SetCollisionObjectType(ECollisionChannel::ECC_WorldDynamic);
+	Volume->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
+	Volume->SetCollisionResponseToChannel(ECollisionChannel::ECC_Pawn, ECollisionResponse::ECR_Overlap);
+	Volume->SetGenerateOverlapEvents(true);
+	Volume->OnComponentBeginOverlap.AddDynamic(this, &UClimbableSubsystem::OnProximityVolumeBeginOverlap);
+	Volume->RegisterComponent();
+
+	ProximityVolumes.Add(Volume);
+	return Volume;
+}
+
+void UClimbableSubsystem::OnProximityVolumeBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
+                                                       UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep,
+                                                       const FHitResult& SweepResult)
+{
+	if (OtherActor == nullptr)
+	{
+		return;
+	}
+
+	if (auto ClimbingComponent = OtherActor->FindComponentByClass<UClimbingComponent>())
+	{
+		ClimbingComponent->WakeUp();
+	}
+}
+
+int32 UClimbableSubsystem::ClaimRoutePlanningBudget(int32 Requested)
+{
+	const auto TotalBudget = CVarClimbingRoutePlanningBudget.GetValueOnGameThread();
+	if (RoutePlanningFrame != GFrameCounter)
+	{
+		RoutePlanningFrame = GFrameCounter;
+		RoutePlanningBudgetLeft = TotalBudget;
+		NumRoutePlannersLastFrame = NumRoutePlannersThisFrame;
+		NumRoutePlannersThisFrame = 0;
+	}
+	NumRoutePlannersThisFrame++;
+
+	// Split evenly between everyone that was planning last frame, so whoever ticks last doesn't starve
+	const auto Share = FMath::Max(TotalBudget / FMath::Max(NumRoutePlannersLastFrame, 1), 1);
+	const auto Granted = FMath::Clamp(FMath::Min(Requested, Share), 0, RoutePlanningBudgetLeft);
+	RoutePlanningBudgetLeft -= Granted;
+	return Granted;
+}
+
+bool UClimbableSubsystem::QueueClimbingTick(UClimbingComponent* Climber, float DeltaTime, ELevelTick TickType)
+{
+	if (!BatchedTickFunction.IsTickFunctionRegistered() || BatchedTickFrame == GFrameCounter)
+	{
+		return false;
+	}
+
+	QueuedClimbingTicks.Add({Climber, DeltaTime, TickType});
+	return true;
+}
+
+void UClimbableSubsystem::TickQueuedClimbers()
+{
+	BatchedTickFrame = GFrameCounter;
+	if (QueuedClimbingTicks.Num() == 0)
+	{
+		return;
+	}
+
+	CLIMBING_SCOPE_CYCLE_COUNTER(STAT_Climbing_BatchedTick);
+
+	// Each climber has already timed queueing itself, this adds the rest of everyone's tick to the frame
+	CLIMBING_PERF_SCOPE(Tick);
+
+	// Everything that finishes the tick early stays on the game thread, since some of it goes through this subsystem
+	ComputingClimbers.Reset();
+	for (int32 i = 0; i < QueuedClimbingTicks.Num(); i++)
+	{
+		const auto& Queued = QueuedClimbingTicks[i];
+		auto Climber = Queued.Climber.Get();
+		if (Climber != nullptr && Climber->BeginTick(Queued.DeltaTime, Queued.TickType))
+		{
+			QueuedClimbingTicks[ComputingClimbers.Num()] = Queued;
+			ComputingClimbers.Add(Climber);
+		}
+	}
+	QueuedClimbingTicks.SetNum(ComputingClimbers.Num(), /*bAllowShrinking: */false);
+
+	// The workers only read the index, so whatever moved has to be in it before they start
+	RefreshMovingClimbables();
+
+	// One batch per worker plus the game thread, each with its own query context so nothing they write is shared
+	const bool bIsParallel = CVarClimbingParallelBatchedTick.GetValueOnGameThread() != 0;
+	const auto NumBatches = bIsParallel
+		                        ? FMath::Min(ComputingClimbers.Num(), FTaskGraphInterface::Get().GetNumWorkerThreads() + 1)
+		                        : 1;
+	while (WorkerQueryContexts.Num() < NumBatches)
+	{
+		auto& Context = WorkerQueryContexts.AddDefaulted_GetRef();
+		Context.bIsDeferred = true;
+		Context.LedgeMemos.Reserve(ReservedLedgeMemos);
+	}
+
+	// Nothing else runs while the game thread waits in here, and each ComputeTick only writes its own climber's TickCommands
+	ParallelFor(NumBatches, [this, NumBatches](int32 Batch)
+	{
+		FClimbingPerfParallelScope ParallelScope;
+		BoundQueryContext() = &WorkerQueryContexts[Batch];
+		ON_SCOPE_EXIT
+		{
+			BoundQueryContext() = nullptr;
+		};
+
+		const auto First = ComputingClimbers.Num() * Batch / NumBatches;
+		const auto Last = ComputingClimbers.Num() * (Batch + 1) / NumBatches;
+		for (int32 i = First; i < Last; i++)
+		{
+			ComputingClimbers[i]->ComputeTick(QueuedClimbingTicks[i].DeltaTime);
+		}
+	}, /*bForceSingleThread: */!bIsParallel);
+
+	for (int32 Batch = 0; Batch < NumBatches; Batch++)
+	{
+		CommitQueryContext(WorkerQueryContexts[Batch]);
+	}
+
+	// Applying one climber can end up destroying another, so they all get looked up again
+	for (const auto& Queued : QueuedClimbingTicks)
+	{
+		if (auto Climber = Queued.Climber.Get())
+		{
+			Climber->ApplyTick(Queued.DeltaTime, Queued.TickType);
+		}
+	}
+
+	QueuedClimbingTicks.Reset();
+	ComputingClimbers.Reset();
+}
+
+UClimbableSubsystem::FQueryContext*& UClimbableSubsystem::BoundQueryContext()
+{
+	// A thread_local member can't be exported, hiding it in here keeps it out of the class
+	static thread_local FQueryContext* Context = nullptr;
+	return Context;
+}
+
+UClimbableSubsystem::FQueryContext& UClimbableSubsystem::GetQueryContext()
+{
+	if (auto Context = BoundQueryContext())
+	{
+		return *Context;
+	}
+
+	check(IsInGameThread());
+	return GameThreadQueryContext;
+}
+
+void UClimbableSubsystem::CommitQueryContext(FQueryContext& Context)
+{
+	// Memos from this frame still hold for the apply pass, older ones were thrown away when the worker first looked
+	if (Context.LedgeMemoFrame == GFrameCounter && Context.LedgeMemos.Num() > 0)
+	{
+		ResetStaleLedgeMemos(GameThreadQueryContext);
+		for (const auto& Memo : Context.LedgeMemos)
+		{
+			GameThreadQueryContext.LedgeMemos.Add(Memo.Key, Memo.Value);
+		}
+	}
+
+	for (const auto& Pending : Context.PendingObstructions)
+	{
+		const auto& Cached = Pending.Value;
+		CacheObstruction(Pending.Key, FTransform(Cached.HangingRotation, Cached.HangingLocation),
+		                 FCollisionShape::MakeCapsule(Cached.CapsuleRadius, Cached.CapsuleHalfHeight), Cached.bIsObstructed);
+	}
+
+	for (const auto& Pending : Context.PendingSeams)
+	{
+		// Unregistering a graph is the only thing that removes a node, and that can't happen while the workers run
+		if (auto BakedNode = BakedNodes.Find(Pending.BakedFrom))
+		{
+			BakedNode->bHasUnbakedNearby = Pending.bHasUnbakedNearby;
+			BakedNode->SeamGeneration = Pending.Generation;
+			BakedNode->SeamRadius = Pending.Radius;
+		}
+	}
+
+	Context.PendingObstructions.Reset();
+	Context.PendingSeams.Reset();
+}
+
+void UClimbableSubsystem::GetMovingClimbables(TArray<AClimbable*>& OutClimbables) const
+{
+	OutClimbables.Reset();
+	for (auto EntryIndex : MovingEntries)
+	{
+		if (auto Climbable = Entries[EntryIndex].Climbable.Get())
+		{
+			OutClimbables.Add(Climbable);
+		}
+	}
+}
+
+TSharedRef<const FClimbingCurveTable> UClimbableSubsystem::GetCurveTable(const UCurveFloat* Curve)
+{
+	if (auto Table = CurveTables.Find(Curve))
+	{
+		return *Table;
+	}
+
+	auto Table = MakeShared<FClimbingCurveTable>();
+	Table->Build(Curve);
+	CurveTables.Add(Curve, Table);
+	return Table;
+}
+
+bool UClimbableSubsystem::IsMovingClimbableInBox(const FBox& Box)
+{
+	RefreshMovingClimbables();
+
+	for (auto EntryIndex : MovingEntries)
+	{
+		if (Entries[EntryIndex].Bounds.Intersect(Box))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+FIntVector UClimbableSubsystem::GetCell(const FVector& Location) const
+{
+	return FIntVector(
+		FMath::FloorToInt(Location.X / CellSize),
+		FMath::FloorToInt(Location.Y / CellSize),
+		FMath::FloorToInt(Location.Z / CellSize));
+}
+
+void UClimbableSubsystem::AddToCells(int32 EntryIndex)
+{
+	const auto& Entry = Entries[EntryIndex];
+	for (int32 X = Entry.MinCell.X; X <= Entry.MaxCell.X; X++)
+	{
+		for (int32 Y = Entry.MinCell.Y; Y <= Entry.MaxCell.Y; Y++)
+		{
+			for (int32 Z = Entry.MinCell.Z; Z <= Entry.MaxCell.Z; Z++)
+			{
+				Cells.FindOrAdd(FIntVector(X, Y, Z)).Add(EntryIndex);
+			}
+		}
+	}
+}
+
+void UClimbableSubsystem::RemoveFromCells(int32 EntryIndex)
+{
+	const auto& Entry = Entries[EntryIndex];
+	for (int32 X = Entry.MinCell.X; X <= Entry.MaxCell.X; X++)
+	{
+		for (int32 Y = Entry.MinCell.Y; Y <= Entry.MaxCell.Y; Y++)
+		{
+			for (int32 Z = Entry.MinCell.Z; Z <= Entry.MaxCell.Z; Z++)
+			{
+				const FIntVector CellKey(X, Y, Z);
+				auto Cell = Cells.Find(CellKey);
+				if (Cell == nullptr)
+				{
+					continue;
+				}
+
+				Cell->RemoveSwap(EntryIndex);
+				if (Cell->Num() == 0)
+				{
+					Cells.Remove(CellKey);
+				}
+			}
+		}
+	}
+}
+
+void UClimbableSubsystem::RefreshEntryBounds(FClimbableEntry& Entry) const
+{
+	auto Climbable = Entry.Climbable.Get();
+	if (Climbable == nullptr)
+	{
+		return;
+	}
+
+	// Only the climbable collision counts, anything else on the actor is just there to be bumped into
+	FBox Bounds(ForceInit);
+	TInlineComponentArray<UPrimitiveComponent*> Primitives(Climbable);
+	for (auto Primitive : Primitives)
+	{
+		if (ClimbingCollision::IsClimbableCollision(Primitive))
+		{
+			Bounds += Primitive->Bounds.GetBox();
+		}
+	}
+
+	// Climbables that haven't been through the ClimbableCollision commandlet yet
+	if (!Bounds.IsValid)
+	{
+		FVector Origin, Extent;
+		Climbable->GetActorBounds(/*bOnlyCollidingComponents: */true, Origin, Extent);
+		Bounds = FBox::BuildAABB(Origin, Extent);
+	}
+
+	Entry.Location = Climbable->GetActorLocation();
+	Entry.Bounds = Bounds;
+	Entry.MinCell = GetCell(Entry.Bounds.Min);
+	Entry.MaxCell = GetCell(Entry.Bounds.Max);
+}
+
+void UClimbableSubsystem::RefreshMovingClimbables()
+{
+	if (LastMovingRefreshFrame == GFrameCounter)
+	{
+		return;
+	}
+
+	// The worker contexts can only read the index, TickQueuedClimbers brings it up to date before handing them out
+	check(!GetQueryContext().bIsDeferred);
+	LastMovingRefreshFrame = GFrameCounter;
+
+	const auto Now = GetWorld()->GetTimeSeconds();
+	const auto SettleTime = CVarClimbingMovingClimbableSettleTime.GetValueOnGameThread();
+	for (int32 i = MovingEntries.Num() - 1; i >= 0; i--)
+	{
+		auto& Entry = Entries[MovingEntries[i]];
+		auto Climbable = Entry.Climbable.Get();
+		if (Climbable == nullptr)
+		{
+			continue;
+		}
+
+		if (!Climbable->GetActorLocation().Equals(Entry.Location))
+		{
+			UpdateClimbable(Climbable);
+		}
+		else
+		{
+			// It might still be rotating in place
+			Mirror.Write(MovingEntries[i], Climbable, Entry.bIsMoving);
+		}
+
+		// Once it's been told it isn't moving any more and has stayed put, stop refreshing it every frame
+		if (!Climbable->bIsMoving && Now - Entry.LastMovedTime > SettleTime)
+		{
+			Entry.bIsMoving = false;
+			Mirror.Write(MovingEntries[i], Climbable, Entry.bIsMoving);
+			MovingEntries.RemoveAtSwap(i, 1, /*bAllowShrinking: */false);
+			Generation++;
+		}
+	}
+}
+
+void UClimbableSubsystem::MarkMoving(int32 EntryIndex)
+{
+	auto& Entry = Entries[EntryIndex];
+	Entry.LastMovedTime = GetWorld()->GetTimeSeconds();
+	if (Entry.bIsMoving)
+	{
+		return;
+	}
+
+	// Anything cached on it being static, like the graph's seam checks, has to be worked out again
+	Entry.bIsMoving = true;
+	MovingEntries.Add(EntryIndex);
+	Generation++;
+}
+
+void UClimbableSubsystem::OnClimbableMoved(USceneComponent* Component, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	// The cells and bounds are brought up to date the next time anyone queries, however many times it moves before then
+	auto EntryIndex = EntryLookup.Find(Component->GetOwner());
+	if (EntryIndex != nullptr)
+	{
+		MarkMoving(*EntryIndex);
+	}
+}
+
+void UClimbableSubsystem::RegisterLevel(ULevel* Level)
+{
+	if (Level == nullptr)
+	{
+		return;
+	}
+
+	for (auto Actor : Level->Actors)
+	{
+		RegisterClimbable(Cast<AClimbable>(Actor));
+	}
+
+	// The graph checks its climbables against the index, so they have to be registered first
+	for (auto Actor : Level->Actors)
+	{
+		RegisterClimbingGraph(Cast<AClimbingGraph>(Actor));
+	}
+
+	for (auto Actor : Level->Actors)
+	{
+		InvalidateObstructionsInBox(WatchObstacle(Actor));
+	}
+}
+
+void UClimbableSubsystem::RegisterClimbingGraph(AClimbingGraph* Graph)
+{
+	if (Graph == nullptr || Graph->GetLevel() == nullptr)
+	{
+		return;
+	}
+
+	// If anything was added, removed or moved since the bake, the connections can't be trusted any more
+	int32 NumStaticClimbables = 0;
+	for (auto Actor : Graph->GetLevel()->Actors)
+	{
+		auto Climbable = Cast<AClimbable>(Actor);
+		if (Climbable != nullptr && !Climbable->bIsMoving)
+		{
+			NumStaticClimbables++;
+		}
+	}
+
+	bool bIsUpToDate = NumStaticClimbables == Graph->GetNumNodes();
+	for (int32 i = 0; i < Graph->GetNumNodes() && bIsUpToDate; i++)
+	{
+		auto Climbable = Graph->GetNode(i);
+		bIsUpToDate = Climbable != nullptr && !Climbable->bIsMoving && EntryLookup.Contains(Climbable) &&
+			Climbable->GetActorLocation().Equals(Graph->GetNodeLocation(i), 1.0f) &&
+			Climbable->GetActorQuat().Equals(Graph->GetNodeRotation(i), KINDA_SMALL_NUMBER);
+	}
+
+	if (!bIsUpToDate)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s is out of date and won't be used, it needs to be baked again"), *Graph->GetName())
+		return;
+	}
+
+	for (int32 i = 0; i < Graph->GetNumNodes(); i++)
+	{
+		auto& BakedNode = BakedNodes.FindOrAdd(Graph->GetNode(i));
+		BakedNode.Graph = Graph;
+		BakedNode.Node = i;
+	}
+}
+
+void UClimbableSubsystem::UnregisterClimbingGraph(AClimbingGraph* Graph)
+{
+	for (auto It = BakedNodes.CreateIterator(); It; ++It)
+	{
+		auto BakedGraph = It->Value.Graph.Get();
+		if (BakedGraph == nullptr || BakedGraph == Graph)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+bool UClimbableSubsystem::GetBakedNeighbours(const AClimbable* Climbable, float DetectionRadius, TArrayView<AActor* const> IgnoreList,
+                                             TArray<AClimbable*>& OutClimbables, TArray<int32>* OutSlots)
+{
+	auto BakedNode = BakedNodes.Find(Climbable);
+	auto Graph = BakedNode != nullptr ? BakedNode->Graph.Get() : nullptr;
+	if (Graph == nullptr || Graph->GetDetectionRadius() != DetectionRadius)
+	{
+		return false;
+	}
+
+	OutClimbables.Reset();
+	if (OutSlots != nullptr)
+	{
+		OutSlots->Reset();
+	}
+
+	for (auto Neighbour : Graph->GetNeighbours(BakedNode->Node))
+	{
+		auto NeighbourClimbable = Graph->GetNode(Neighbour);
+
+		// Anything destroyed since has already left the index, and anything that started moving gets found with the moving ones
+		auto EntryIndex = EntryLookup.Find(NeighbourClimbable);
+		if (EntryIndex == nullptr || Entries[*EntryIndex].bIsMoving || IgnoreList.Contains(NeighbourClimbable))
+		{
+			continue;
+		}
+
+		OutClimbables.Add(NeighbourClimbable);
+		if (OutSlots != nullptr)
+		{
+			OutSlots->Add(*EntryIndex);
+		}
+	}
+
+	return true;
+}
+
+void UClimbableSubsystem::AppendMovingInSphere(const FVector& Center, float Radius, TArrayView<AActor* const> IgnoreList,
+                                               TArray<AClimbable*>& OutClimbables, TArray<int32>* OutSlots)
+{
+	RefreshMovingClimbables();
+
+	const auto RadiusSquared = FMath::Square(Radius);
+	for (auto EntryIndex : MovingEntries)
+	{
+		const auto& Entry = Entries[EntryIndex];
+		auto Climbable = Entry.Climbable.Get();
+		if (Climbable == nullptr || IgnoreList.Contains(Climbable) || Entry.Bounds.ComputeSquaredDistanceToPoint(Center) > RadiusSquared)
+		{
+			continue;
+		}
+
+		OutClimbables.Add(Climbable);
+		if (OutSlots != nullptr)
+		{
+			OutSlots->Add(EntryIndex);
+		}
+	}
+}
+
+void UClimbableSubsystem::AppendUnbakedInSphere(const AClimbable* BakedFrom, const FVector& Center, float Radius,
+                                                TArrayView<AActor* const> IgnoreList, TArray<AClimbable*>& OutClimbables,
+                                                TArray<int32>* OutSlots)
+{
+	AppendMovingInSphere(Center, Radius, IgnoreList, OutClimbables, OutSlots);
+
+	auto BakedNode = BakedNodes.Find(BakedFrom);
+	auto Graph = BakedNode != nullptr ? BakedNode->Graph.Get() : nullptr;
+	if (Graph == nullptr)
+	{
+		return;
+	}
+
+	// Most climbables are nowhere near another level, so once we know there's nothing foreign around one we don't look again
+	// until something is added or removed
+	const bool bIsSeamKnown = BakedNode->SeamGeneration == Generation && BakedNode->SeamRadius == Radius;
+	if (bIsSeamKnown && !BakedNode->bHasUnbakedNearby)
+	{
+		return;
+	}
+
+	auto& Context = GetQueryContext();
+	auto& SeamClimbables = Context.SeamClimbables;
+	auto& SeamSlots = Context.SeamSlots;
+	QuerySphere(Center, Radius, TArrayView<AActor* const>(), SeamClimbables, &SeamSlots);
+
+	bool bHasUnbakedNearby = false;
+	for (int32 i = 0; i < SeamClimbables.Num(); i++)
+	{
+		// Moving climbables were added above already
+		auto Climbable = SeamClimbables[i];
+		if (Entries[SeamSlots[i]].bIsMoving)
+		{
+			continue;
+		}
+
+		auto NeighbourNode = BakedNodes.Find(Climbable);
+		if (NeighbourNode != nullptr && NeighbourNode->Graph.Get() == Graph)
+		{
+			continue;
+		}
+
+		bHasUnbakedNearby = true;
+		if (!IgnoreList.Contains(Climbable))
+		{
+			OutClimbables.Add(Climbable);
+			if (OutSlots != nullptr)
+			{
+				OutSlots->Add(SeamSlots[i]);
+			}
+		}
+	}
+
+	if (Context.bIsDeferred)
+	{
+		Context.PendingSeams.Add({BakedFrom, bHasUnbakedNearby, Generation, Radius});
+		return;
+	}
+
+	BakedNode->bHasUnbakedNearby = bHasUnbakedNearby;
+	BakedNode->SeamGeneration = Generation;
+	BakedNode->SeamRadius = Radius;
+}
+
+void UClimbableSubsystem::OnActorSpawned(AActor* Actor)
+{
+	RegisterClimbable(Cast<AClimbable>(Actor));
+	InvalidateObstructionsInBox(WatchObstacle(Actor));
+}
+
+void UClimbableSubsystem::OnLevelAdded(ULevel* Level, UWorld* World)
+{
+	if (World == GetWorld() && World->HasBegunPlay())
+	{
+		RegisterLevel(Level);
+	}
+}
+
+void UClimbableSubsystem::OnLevelRemoved(ULevel* Level, UWorld* World)
+{
+	if (World != GetWorld() || Level == nullptr)
+	{
+		return;
+	}
+
+	for (auto Actor : Level->Actors)
+	{
+		if (auto Climbable = Cast<AClimbable>(Actor))
+		{
+			UnregisterClimbable(Climbable);
+		}
+		else if (auto Graph = Cast<AClimbingGraph>(Actor))
+		{
+			UnregisterClimbingGraph(Graph);
+		}
+	}
+}
+
+void UClimbableSubsystem::OnClimbableEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason)
+{
+	UnregisterClimbable(Cast<AClimbable>(Actor));
+}
+
+bool UClimbableSubsystem::FindCachedObstruction(const AActor* Climbable, const FTransform& HangingTransform, const FCollisionShape& Capsule,
+	bool& bOutIsObstructed)
+{
+	const auto Lifetime = CVarClimbingObstructionCacheLifetime.GetValueOnAnyThread();
+	if (Lifetime <= 0.0f)
+	{
+		INC_DWORD_STAT(STAT_Climbing_ObstructionCacheMisses);
+		return false;
+	}
+
+	// Checks a worker made earlier in the batch haven't been committed yet, the latest one for the climbable is the one that counts
+	auto& Context = GetQueryContext();
+	for (int32 i = Context.PendingObstructions.Num() - 1; i >= 0; i--)
+	{
+		const auto& Pending = Context.PendingObstructions[i];
+		if (Pending.Key == Climbable)
+		{
+			if (IsSameHangingCapsule(Pending.Value, HangingTransform, Capsule))
+			{
+				INC_DWORD_STAT(STAT_Climbing_ObstructionCacheHits);
+				bOutIsObstructed = Pending.Value.bIsObstructed;
+				return true;
+			}
+			break;
+		}
+	}
+
+	const auto Cached = CachedObstructions.Find(Climbable);
+	if (Cached == nullptr || GetWorld()->GetTimeSeconds() - Cached->Time > Lifetime ||
+		!IsSameHangingCapsule(*Cached, HangingTransform, Capsule))
+	{
+		INC_DWORD_STAT(STAT_Climbing_ObstructionCacheMisses);
+		return false;
+	}
+
+	INC_DWORD_STAT(STAT_Climbing_ObstructionCacheHits);
+	bOutIsObstructed = Cached->bIsObstructed;
+	return true;
+}
+
+bool UClimbableSubsystem::IsSameHangingCapsule(const FCachedObstruction& Cached, const FTransform& HangingTransform,
+                                               const FCollisionShape& Capsule)
+{
+	return FMath::IsNearlyEqual(Cached.CapsuleRadius, Capsule.GetCapsuleRadius()) &&
+		FMath::IsNearlyEqual(Cached.CapsuleHalfHeight, Capsule.GetCapsuleHalfHeight()) &&
+		HangingTransform.GetLocation().Equals(Cached.HangingLocation, 1.0f) &&
+		HangingTransform.GetRotation().Equals(Cached.HangingRotation, KINDA_SMALL_NUMBER);
+}
+
+void UClimbableSubsystem::CacheObstruction(const AActor* Climbable, const FTransform& HangingTransform, const FCollisionShape& Capsule,
+	bool bIsObstructed)
+{
+	if (CVarClimbingObstructionCacheLifetime.GetValueOnAnyThread() <= 0.0f)
+	{
+		return;
+	}
+
+	FCachedObstruction Cached;
+	Cached.HangingLocation = HangingTransform.GetLocation();
+	Cached.HangingRotation = HangingTransform.GetRotation();
+	Cached.CapsuleRadius = Capsule.GetCapsuleRadius();
+	Cached.CapsuleHalfHeight = Capsule.GetCapsuleHalfHeight();
+	Cached.bIsObstructed = bIsObstructed;
+
+	auto& Context = GetQueryContext();
+	if (Context.bIsDeferred)
+	{
+		Context.PendingObstructions.Emplace(Climbable, Cached);
+		return;
+	}
+
+	// A different capsule on the same climbable, only the latest one is kept
+	RemoveCachedObstruction(Climbable);
+	Cached.Bounds = FBox::BuildAABB(Cached.HangingLocation, FVector(Cached.CapsuleHalfHeight));
+	Cached.MinCell = GetCell(Cached.Bounds.Min);
+	Cached.MaxCell = GetCell(Cached.Bounds.Max);
+	Cached.Time = GetWorld()->GetTimeSeconds();
+
+	for (int32 X = Cached.MinCell.X; X <= Cached.MaxCell.X; X++)
+	{
+		for (int32 Y = Cached.MinCell.Y; Y <= Cached.MaxCell.Y; Y++)
+		{
+			for (int32 Z = Cached.MinCell.Z; Z <= Cached.MaxCell.Z; Z++)
+			{
+				ObstructionCells.FindOrAdd(FIntVector(X, Y, Z)).Add(Climbable);
+			}
+		}
+	}
+
+	CachedObstructions.Add(Climbable, Cached);
+}
+
+void UClimbableSubsystem::RemoveCachedObstruction(const AActor* Climbable)
+{
+	FCachedObstruction Cached;
+	if (!CachedObstructions.RemoveAndCopyValue(Climbable, Cached))
+	{
+		return;
+	}
+
+	for (int32 X = Cached.MinCell.X; X <= Cached.MaxCell.X; X++)
+	{
+		for (int32 Y = Cached.MinCell.Y; Y <= Cached.MaxCell.Y; Y++)
+		{
+			for (int32 Z = Cached.MinCell.Z; Z <= Cached.MaxCell.Z; Z++)
+			{
+				const FIntVector CellKey(X, Y, Z);
+				auto Cell = ObstructionCells.Find(CellKey);
+				if (Cell == nullptr)
+				{
+					continue;
+				}
+
+				Cell->RemoveSwap(Climbable);
+				if (Cell->Num() == 0)
+				{
+					ObstructionCells.Remove(CellKey);
+				}
+			}
+		}
+	}
+}
+
+void UClimbableSubsystem::InvalidateObstructionsInBox(const FBox& Box)
+{
+	if (CachedObstructions.Num() == 0 || !Box.IsValid)
+	{
+		return;
+	}
+
+	TArray<const AActor*, TInlineAllocator<16>> Invalidated;
+
+	const auto MinCell = GetCell(Box.Min);
+	const auto MaxCell = GetCell(Box.Max);
+	const auto NumCells = static_cast<int64>(MaxCell.X - MinCell.X + 1) * (MaxCell.Y - MinCell.Y + 1) * (MaxCell.Z - MinCell.Z + 1);
+
+	// Something huge, like a whole streamed in level, would walk a lot of empty cells
+	if (NumCells > CachedObstructions.Num())
+	{
+		for (const auto& Pair : CachedObstructions)
+		{
+			if (Pair.Value.Bounds.Intersect(Box))
+			{
+				Invalidated.Add(Pair.Key);
+			}
+		}
+	}
+	else
+	{
+		for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+		{
+			for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+			{
+				for (int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++)
+				{
+					auto Cell = ObstructionCells.Find(FIntVector(X, Y, Z));
+					if (Cell == nullptr)
+					{
+						continue;
+					}
+
+					for (auto Climbable : *Cell)
+					{
+						if (CachedObstructions.FindChecked(Climbable).Bounds.Intersect(Box))
+						{
+							Invalidated.AddUnique(Climbable);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	for (auto Climbable : Invalidated)
+	{
+		RemoveCachedObstruction(Climbable);
+	}
+	INC_DWORD_STAT_BY(STAT_Climbing_ObstructionCacheInvalidations, Invalidated.Num());
+}
+
+FBox UClimbableSubsystem::WatchObstacle(AActor* Actor)
+{
+	FBox Bounds(ForceInit);
+	if (Actor == nullptr || Actor->IsPendingKill())
+	{
+		return Bounds;
+	}
+
+	TInlineComponentArray<UPrimitiveComponent*> Primitives(Actor);
+	for (auto Primitive : Primitives)
+	{
+		if (!UClimbingComponent::CanComponentBlockClimbing(Primitive))
+		{
+			continue;
+		}
+
+		const auto PrimitiveBounds = Primitive->Bounds.GetBox();
+		Bounds += PrimitiveBounds;
+
+		// Static and stationary collision can only get in the way by spawning or going away
+		if (Primitive->Mobility == EComponentMobility::Movable && !WatchedObstacles.Contains(Primitive))
+		{
+			WatchedObstacles.Add(Primitive, PrimitiveBounds);
+			Primitive->TransformUpdated.AddUObject(this, &UClimbableSubsystem::OnObstacleMoved);
+		}
+	}
+
+	if (Bounds.IsValid)
+	{
+		Actor->OnEndPlay.AddUniqueDynamic(this, &UClimbableSubsystem::OnObstacleEndPlay);
+	}
+	return Bounds;
+}
+
+void UClimbableSubsystem::OnObstacleMoved(USceneComponent* Component, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	// Only primitives are ever watched
+	auto Primitive = static_cast<UPrimitiveComponent*>(Component);
+	auto LastBounds = WatchedObstacles.Find(Primitive);
+	if (LastBounds == nullptr)
+	{
+		return;
+	}
+
+	// Moving out of a capsule changes the answer just as much as moving into one
+	const auto NewBounds = Primitive->Bounds.GetBox();
+	InvalidateObstructionsInBox(*LastBounds);
+	InvalidateObstructionsInBox(NewBounds);
+	*LastBounds = NewBounds;
+}
+
+void UClimbableSubsystem::OnObstacleEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason)
+{
+	TInlineComponentArray<UPrimitiveComponent*> Primitives(Actor);
+	for (auto Primitive : Primitives)
+	{
+		if (UClimbingComponent::CanComponentBlockClimbing(Primitive))
+		{
+			InvalidateObstructionsInBox(Primitive->Bounds.GetBox());
+		}
+
+		if (WatchedObstacles.Remove(Primitive) > 0)
+		{
+			Primitive->TransformUpdated.RemoveAll(this);
+		}
+	}
+
+	Actor->OnEndPlay.RemoveDynamic(this, &UClimbableSubsystem::OnObstacleEndPlay);
+}
@@ -0,0 +1,503 @@
+/* Copyright 2019 Alexandrea Shackelford, Zion Nimchuk, All Rights Reserved.
+ * Unauthorized copying or modification of this file, via any medium is strictly prohibited.
+ */
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Components/SceneComponent.h"
+#include "Engine/EngineBaseTypes.h"
+#include "ClimbableSubsystem.generated.h"
+
+class AClimbable;
+class AClimbingGraph;
+class ASplineLedge;
+class ULevel;
+class UCurveFloat;
+class USphereComponent;
+class UPrimitiveComponent;
+class UClimbableSubsystem;
+class UClimbingComponent;
+struct FCollisionShape;
+
+/**
+ * Structure-of-arrays copy of the climbable data that candidate scoring needs, indexed by the climbable's slot in the
+ * subsystem. This lets FindBestClimbable read positions and rotations linearly instead of through every actor's root component.
+ */
+struct FClimbableMirror
+{
+	enum EFlags : uint8
+	{
+		CMF_IsLedge = 1 << 0,
+		CMF_IsMoving = 1 << 1
+	};
+
+	TArray<float> PositionX;
+	TArray<float> PositionY;
+	TArray<float> PositionZ;
+	TArray<float> Yaw;
+	TArray<float> Pitch;
+	TArray<uint8> Flags;
+
+	void SetNum(int32 NewNum);
+	/* bIsMoving is what the index thinks, which also covers climbables that move without setting their own bIsMoving*/
+	void Write(int32 Slot, const AClimbable* Climbable, bool bIsMoving);
+	void Clear(int32 Slot);
+};
+
+/* A movement curve sampled at evenly spaced times, so that reading it is a lookup and a lerp instead of a search through its keys*/
+struct FClimbingCurveTable
+{
+	static constexpr int32 NumSamples = 128;
+
+	float MinTime = 0.0f;
+	float MaxTime = 0.0f;
+	TArray<float> Samples;
+
+	void Build(const UCurveFloat* Curve);
+	float Evaluate(float Time) const;
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FClimbableUnregisteredDelegate, const AClimbable*);
+
+/* Runs the climbers that queued themselves with UClimbableSubsystem::QueueClimbingTick, after they've all had their own tick*/
+USTRUCT()
+struct FClimbingBatchedTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	UClimbableSubsystem* Subsystem = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread,
+		const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FClimbingBatchedTickFunction> : public TStructOpsTypeTraitsBase2<FClimbingBatchedTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/**
+ * Keeps every AClimbable in the world in a spatial hash, so that the climbing component can gather
+ * candidates without running a physics overlap against all of WorldStatic and WorldDynamic.
+ *
+ * Queries can be made from the worker threads while TickQueuedClimbers is computing the batched climbers, everything else is game thread
+ * only. Each batch queries through its own FQueryContext, which only reads the index and the shared caches.
+ */
+UCLASS()
+class THEELDER_API UClimbableSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/* Adds a climbable to the index, calling this on an already registered climbable does nothing*/
+	void RegisterClimbable(AClimbable* Climbable);
+
+	void UnregisterClimbable(AClimbable* Climbable);
+
+	/* Broadcast when a climbable leaves the index, which it does when it's destroyed or its level is streamed out, so anything keyed on it
+	 * can be thrown away before its address gets reused*/
+	FClimbableUnregisteredDelegate OnClimbableUnregistered;
+
+	/* Moves a climbable to its new cells and tracks it as moving until it settles again. Movable climbables are picked up through their
+	 * root component's TransformUpdated, so this only needs calling for anything moved without one*/
+	void UpdateClimbable(AClimbable* Climbable);
+
+	/**
+	 * \brief Gathers all the climbables whose collision bounds touch the sphere
+	 * \param IgnoreList Climbables that shouldn't be returned
+	 * \param OutSlots (Optional) Filled with the mirror slot of each returned climbable
+	 * \param OutBounds (Optional) Filled with the bounds of each returned climbable
+	 * \return Returns true if anything was found
+	 */
+	bool QuerySphere(const FVector& Center, float Radius, TArrayView<AActor* const> IgnoreList, TArray<AClimbable*>& OutClimbables,
+		TArray<int32>* OutSlots = nullptr, TArray<FBox>* OutBounds = nullptr);
+
+	/**
+	 * \brief Same as QuerySphere, but for an upright capsule, like the one used while flying forward in the air.
+	 */
+	bool QueryCapsule(const FVector& Center, float Radius, float HalfHeight, TArrayView<AActor* const> IgnoreList, TArray<AClimbable*>& OutClimbables,
+		TArray<int32>* OutSlots = nullptr, TArray<FBox>* OutBounds = nullptr);
+
+	/**
+	 * \brief Gathers all the climbables touched by an upright capsule moving along the path
+	 * \param Points The path, at least two points
+	 */
+	bool QueryPath(TArrayView<const FVector> Points, float Radius, float HalfHeight, TArrayView<AActor* const> IgnoreList,
+		TArray<AClimbable*>& OutClimbables, TArray<int32>* OutSlots = nullptr, TArray<FBox>* OutBounds = nullptr);
+
+	/* The test QueryPath does for each segment of the path. It can let through boxes that are just off the capsule's rounded edges.*/
+	static bool DoesSweptCapsuleTouchBox(const FBox& Bounds, const FVector& Start, const FVector& End, float Radius, float HalfHeight);
+
+	/**
+	 * \brief Same as QuerySphere, but shares the work between everyone querying the same area this frame. The first query in an area
+	 * is made a bit bigger and kept for the rest of the frame, anyone whose sphere fits inside it just filters that result.
+	 * So the cost goes up with the number of distinct areas, not the number of climbers.
+	 */
+	bool QuerySphereShared(const FVector& Center, float Radius, TArrayView<AActor* const> IgnoreList, TArray<AClimbable*>& OutClimbables,
+		TArray<int32>* OutSlots = nullptr, TArray<FBox>* OutBounds = nullptr);
+
+	/**
+	 * \brief Gathers the climbables that can be reached from a static climbable, according to its level's baked AClimbingGraph
+	 * \param DetectionRadius The radius the caller would otherwise query with, graphs baked with a different one aren't used
+	 * \return Returns false if there's no up to date graph for the climbable, in which case the caller needs to query instead
+	 */
+	bool GetBakedNeighbours(const AClimbable* Climbable, float DetectionRadius, TArrayView<AActor* const> IgnoreList,
+		TArray<AClimbable*>& OutClimbables, TArray<int32>* OutSlots = nullptr);
+
+	/* Adds every moving climbable touching the sphere to the output, without emptying it first*/
+	void AppendMovingInSphere(const FVector& Center, float Radius, TArrayView<AActor* const> IgnoreList,
+		TArray<AClimbable*>& OutClimbables, TArray<int32>* OutSlots = nullptr);
+
+	/**
+	 * \brief Adds everything touching the sphere that BakedFrom's graph couldn't know about, without emptying the output first. That's the
+	 * moving climbables, and the static ones from other levels or that weren't baked, which only climbables by a level seam have.
+	 * \param BakedFrom The climbable GetBakedNeighbours was asked about, the sphere is expected to be centred on it
+	 */
+	void AppendUnbakedInSphere(const AClimbable* BakedFrom, const FVector& Center, float Radius, TArrayView<AActor* const> IgnoreList,
+		TArray<AClimbable*>& OutClimbables, TArray<int32>* OutSlots = nullptr);
+
+	/**
+	 * \brief Hands out part of this frame's route planning budget, which is set with Climbing.RoutePlanningBudget
+	 * \return How many climbables the caller can expand this frame, which is 0 once everyone else has used it up
+	 */
+	int32 ClaimRoutePlanningBudget(int32 Requested);
+
+	/* Returns true if the location is inside one of the proximity volumes around the climbable clusters*/
+	bool IsInsideProximityVolume(const FVector& Location) const;
+
+	/* Every registered climbable that's moving, or has moved recently*/
+	void GetMovingClimbables(TArray<AClimbable*>& OutClimbables) const;
+
+	/* Returns true if a moving climbable is currently touching the box*/
+	bool IsMovingClimbableInBox(const FBox& Box);
+
+	int32 GetNumClimbables() const { return EntryLookup.Num(); }
+
+	/**
+	 * \brief Same result as ASplineLedge::GetClimbUpTransform, but remembered for the rest of the frame for each querying actor,
+	 * and looked up in a pre-sampled table instead of projecting onto the spline when Climbing.UseSampledLedges is on.
+	 */
+	FTransform GetClimbUpTransform(const ASplineLedge* Ledge, AActor* QueryingActor);
+
+	/**
+	 * \brief The curve baked into a table, which is shared by every climber using that curve. It's built the first time it's asked for,
+	 * so changes made to the curve after that aren't picked up until the world is reloaded.
+	 */
+	TSharedRef<const FClimbingCurveTable> GetCurveTable(const UCurveFloat* Curve);
+
+	/**
+	 * \brief Looks up an obstruction check that was done for the same hanging capsule on the climbable. Results stay valid until
+	 * something that can block Mokosh spawns, moves or is destroyed inside the capsule, or Climbing.ObstructionCacheLifetime runs out.
+	 * \return Returns false if there's no usable result, in which case the caller needs to check and hand it to CacheObstruction
+	 */
+	bool FindCachedObstruction(const AActor* Climbable, const FTransform& HangingTransform, const FCollisionShape& Capsule, bool& bOutIsObstructed);
+
+	/* Remembers an obstruction check for FindCachedObstruction, only do this for climbables that stay put*/
+	void CacheObstruction(const AActor* Climbable, const FTransform& HangingTransform, const FCollisionShape& Capsule, bool bIsObstructed);
+
+	/* Throws away every cached obstruction check whose capsule touches the box*/
+	void InvalidateObstructionsInBox(const FBox& Box);
+
+	/**
+	 * \brief Puts off the rest of the climber's tick until after physics, when every climber that was queued this frame is ticked together.
+	 * Their ComputeTicks, which is where detection and rating happen, run on worker threads side by side, then their ApplyTicks run one
+	 * after another on the game thread.
+	 * \return Returns false if the batch can't pick the climber up this frame, in which case it needs to tick on its own
+	 */
+	bool QueueClimbingTick(UClimbingComponent* Climber, float DeltaTime, ELevelTick TickType);
+
+	/* The mirror is only guaranteed to be up to date for moving climbables after a query has been made this frame*/
+	const FClimbableMirror& GetMirror() const { return Mirror; }
+
+	/* Goes up every time a climbable is added or removed, so cached query results can tell when they're stale*/
+	uint32 GetGeneration() const { return Generation; }
+
+private:
+
+	struct FClimbableEntry
+	{
+		TWeakObjectPtr<AClimbable> Climbable;
+
+		/* The bounds of the colliding components, which is what the physics overlap would've tested against*/
+		FBox Bounds;
+
+		/* Location the bounds were taken at, used to tell if a moving climbable needs to change cells*/
+		FVector Location;
+
+		FIntVector MinCell;
+		FIntVector MaxCell;
+
+		bool bIsMoving = false;
+
+		/* When a moving climbable was last seen moving, it goes back to being static once it's been still for a while*/
+		float LastMovedTime = 0.0f;
+
+		/* Bound on movable climbables' root components, so they go back to being tracked as soon as they move again*/
+		TWeakObjectPtr<USceneComponent> WatchedRoot;
+		FDelegateHandle TransformUpdatedHandle;
+	};
+
+	/* Size of a single cell in the hash, picked to be around the default detection radius*/
+	static constexpr float CellSize = 1000.0f;
+
+	TArray<FClimbableEntry> Entries;
+	TArray<int32> FreeEntries;
+	TMap<const AActor*, int32> EntryLookup;
+	/* Moving climbables hop between cells all the time, so the handful of entries in a cell are kept off the heap*/
+	TMap<FIntVector, TArray<int32, TInlineAllocator<4>>> Cells;
+
+	/* Shares its indices with Entries*/
+	FClimbableMirror Mirror;
+
+	/* Climbables with bIsMoving set or that have been seen moving, these get re-hashed and re-mirrored once per frame before a query.
+	 * They stay in here until bIsMoving is cleared and they've been still for Climbing.MovingClimbableSettleTime.*/
+	TArray<int32> MovingEntries;
+	uint64 LastMovingRefreshFrame = 0;
+
+	/* Size of the cells used to group climbables into clusters for the proximity volumes*/
+	static constexpr float ProximityClusterSize = 4000.0f;
+
+	/* Holds the proximity volumes, which wake up sleeping climbing components when a character walks into them*/
+	UPROPERTY()
+	AActor* ProximityVolumeOwner = nullptr;
+
+	UPROPERTY()
+	TArray<USphereComponent*> ProximityVolumes;
+
+	/* A query that was made this frame, which other climbers in the same area can reuse*/
+	struct FSharedQueryRegion
+	{
+		FVector Center;
+		float Radius;
+		TArray<AClimbable*> Climbables;
+		TArray<int32> Slots;
+		TArray<FBox> Bounds;
+	};
+
+	/* How much bigger than requested a shared query is made, so that nearby climbers fall inside it*/
+	static constexpr float SharedQueryPadding = 500.0f;
+
+	/* Points sampled evenly along a ledge's spline at registration, in the ledge's local space so that it survives the ledge moving*/
+	struct FLedgeSampleTable
+	{
+		TArray<float> X;
+		TArray<float> Y;
+		TArray<float> Z;
+		TArray<FQuat> Rotations;
+	};
+
+	/* Distance between samples along a ledge spline*/
+	static constexpr float LedgeSampleSpacing = 50.0f;
+
+	/* Keeps the lookup bounded for really long castle walls*/
+	static constexpr int32 MaxLedgeSamples = 1024;
+
+	TMap<const AActor*, FLedgeSampleTable> LedgeTables;
+
+	struct FLedgeMemo
+	{
+		FVector QueryLocation;
+		FTransform Transform;
+		bool bIsValid = false;
+	};
+
+	/* Reserved up front and kept between frames, so memoizing a ledge doesn't allocate*/
+	static constexpr int32 ReservedLedgeMemos = 32;
+
+	TMap<TWeakObjectPtr<const UCurveFloat>, TSharedRef<const FClimbingCurveTable>> CurveTables;
+
+	struct FCachedObstruction
+	{
+		FVector HangingLocation;
+		FQuat HangingRotation;
+		float CapsuleRadius;
+		float CapsuleHalfHeight;
+
+		/* Around the capsule whichever way it's turned*/
+		FBox Bounds;
+		FIntVector MinCell;
+		FIntVector MaxCell;
+		float Time;
+		bool bIsObstructed;
+	};
+
+	TMap<const AActor*, FCachedObstruction> CachedObstructions;
+
+	/* Same cells as the climbable hash, but holding the climbables whose cached hanging capsule is in them*/
+	TMap<FIntVector, TArray<const AActor*, TInlineAllocator<4>>> ObstructionCells;
+
+	/* Movable components that could block Mokosh, with the bounds they had the last time they moved*/
+	TMap<TWeakObjectPtr<UPrimitiveComponent>, FBox> WatchedObstacles;
+
+	/* Where a climbable is in its level's baked graph*/
+	struct FBakedNode
+	{
+		TWeakObjectPtr<AClimbingGraph> Graph;
+		int32 Node = INDEX_NONE;
+
+		/* Whether there are static climbables around it that aren't in its graph, as of SeamGeneration and SeamRadius*/
+		bool bHasUnbakedNearby = false;
+		uint32 SeamGeneration = 0;
+		float SeamRadius = -1.0f;
+	};
+
+	/* Only holds climbables from graphs that were still up to date when their level was loaded*/
+	TMap<const AActor*, FBakedNode> BakedNodes;
+
+	/* What AppendUnbakedInSphere found out about a seam, for a context that can't write it into BakedNodes itself*/
+	struct FPendingSeam
+	{
+		const AActor* BakedFrom;
+		bool bHasUnbakedNearby;
+		uint32 Generation;
+		float Radius;
+	};
+
+	/**
+	 * Everything a query writes as it goes. The game thread has its own, and TickQueuedClimbers gives every batch of climbers it hands
+	 * to the worker threads another, so their queries don't step on each other. Those worker contexts only read the shared caches,
+	 * anything they'd add to them waits in here until CommitQueryContext runs on the game thread.
+	 */
+	struct FQueryContext
+	{
+		/* Used so that climbables spanning multiple cells are only returned once per query, indexed like Entries*/
+		TArray<uint32> EntryStamps;
+		uint32 QueryStamp = 0;
+
+		/* The areas QuerySphereShared has queried, which are only shared with the other climbers using the same context*/
+		TArray<FSharedQueryRegion> SharedQueryRegions;
+		int32 NumSharedQueryRegions = 0;
+		uint64 SharedQueryFrame = 0;
+
+		/* Keyed on the ledge and the querying actor, emptied at the start of every frame*/
+		TMap<TPair<const AActor*, const AActor*>, FLedgeMemo> LedgeMemos;
+		uint64 LedgeMemoFrame = 0;
+
+		/* Reused by AppendUnbakedInSphere, so looking across a seam doesn't allocate*/
+		TArray<AClimbable*> SeamClimbables;
+		TArray<int32> SeamSlots;
+
+		/* Set on the worker contexts, which hold their obstruction checks and seams back in here instead of writing them*/
+		bool bIsDeferred = false;
+		TArray<TPair<const AActor*, FCachedObstruction>> PendingObstructions;
+		TArray<FPendingSeam> PendingSeams;
+	};
+
+	FQueryContext GameThreadQueryContext;
+
+	/* One for each batch of climbers in TickQueuedClimbers, kept between frames along with their memory*/
+	TArray<FQueryContext> WorkerQueryContexts;
+
+	/* The context a worker thread has been given by TickQueuedClimbers, or null*/
+	static FQueryContext*& BoundQueryContext();
+
+	FQueryContext& GetQueryContext();
+
+	/* Writes a worker context's memos, obstruction checks and seams into the shared caches*/
+	void CommitQueryContext(FQueryContext& Context);
+
+	static void ResetStaleLedgeMemos(FQueryContext& Context);
+
+	/* Whether the cached check was made for the same hanging capsule*/
+	static bool IsSameHangingCapsule(const FCachedObstruction& Cached, const FTransform& HangingTransform, const FCollisionShape& Capsule);
+
+	friend struct FClimbingBatchedTickFunction;
+
+	FClimbingBatchedTickFunction BatchedTickFunction;
+
+	struct FQueuedClimbingTick
+	{
+		TWeakObjectPtr<UClimbingComponent> Climber;
+		float DeltaTime;
+		ELevelTick TickType;
+	};
+
+	TArray<FQueuedClimbingTick> QueuedClimbingTicks;
+
+	/* The climbers in QueuedClimbingTicks that still had something to do after BeginTick, in the same order*/
+	TArray<UClimbingComponent*> ComputingClimbers;
+
+	/* The batch has already gone by once this is the current frame, anyone queueing after that ticks on their own*/
+	uint64 BatchedTickFrame = 0;
+
+	void TickQueuedClimbers();
+
+	uint64 RoutePlanningFrame = 0;
+	int32 RoutePlanningBudgetLeft = 0;
+	int32 NumRoutePlannersThisFrame = 0;
+	int32 NumRoutePlannersLastFrame = 0;
+
+	uint32 Generation = 0;
+
+	FDelegateHandle ActorSpawnedHandle;
+	FDelegateHandle LevelAddedHandle;
+	FDelegateHandle LevelRemovedHandle;
+
+	FIntVector GetCell(const FVector& Location) const;
+
+	void AddToCells(int32 EntryIndex);
+	void RemoveFromCells(int32 EntryIndex);
+	void RefreshEntryBounds(FClimbableEntry& Entry) const;
+	void RefreshMovingClimbables();
+
+	/* Puts the entry back in MovingEntries if it isn't already, RefreshMovingClimbables takes it from there*/
+	void MarkMoving(int32 EntryIndex);
+
+	void OnClimbableMoved(USceneComponent* Component, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+	void RemoveCachedObstruction(const AActor* Climbable);
+
+	/**
+	 * \brief Starts listening for the actor's blocking collision moving or going away, so the obstruction checks around it can be thrown out
+	 * \return The bounds of everything on the actor that can block Mokosh, which isn't valid if there's nothing
+	 */
+	FBox WatchObstacle(AActor* Actor);
+
+	void OnObstacleMoved(USceneComponent* Component, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+	UFUNCTION()
+	void OnObstacleEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason);
+
+	void BuildLedgeTable(const ASplineLedge* Ledge);
+	FTransform FindClosestLedgeSample(const FLedgeSampleTable& Table, const FTransform& LedgeTransform, const FVector& WorldLocation) const;
+
+	template <typename OverlapFunc>
+	bool QueryBox(const FBox& QueryBounds, TArrayView<AActor* const> IgnoreList, TArray<AClimbable*>& OutClimbables, TArray<int32>* OutSlots,
+		TArray<FBox>* OutBounds, OverlapFunc&& Overlaps);
+
+	void RegisterLevel(ULevel* Level);
+
+	/* Makes a graph's climbables available to GetBakedNeighbours, as long as nothing in the level has changed since the bake*/
+	void RegisterClimbingGraph(AClimbingGraph* Graph);
+	void UnregisterClimbingGraph(AClimbingGraph* Graph);
+
+	/* Puts a sphere around every cluster of climbables, plus one on each moving climbable that follows it around*/
+	void BuildProximityVolumes();
+
+	/* Makes sure a climbable that was added after BeginPlay is covered by a proximity volume*/
+	void AddProximityVolumeFor(const AClimbable* Climbable);
+
+	USphereComponent* CreateProximityVolume(const FVector& Center, float Radius);
+
+	UFUNCTION()
+	void OnProximityVolumeBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp,
+		int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+
+	void OnActorSpawned(AActor* Actor);
+	void OnLevelAdded(ULevel* Level, UWorld* World);
+	void OnLevelRemoved(ULevel* Level, UWorld* World);
+
+	UFUNCTION()
+	void OnClimbableEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason);
+};
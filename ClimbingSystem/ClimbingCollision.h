@@ -0,0 +1,29 @@
+/* Copyright 2019 Alexandrea Shackelford, Zion Nimchuk, All Rights Reserved.
+ * Unauthorized copying or modification of this file, via any medium is strictly prohibited.
+ */
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "Components/PrimitiveComponent.h"
+
+/**
+ * Object type for the collision on every AClimbable and ASplineLedge, so that queries looking for world geometry don't have to
+ * wade through every crystal in range and queries looking for climbables don't have to wade through the world.
+ * It has to match the object channel in DefaultEngine.ini:
+ *
+ *     +DefaultChannelResponses=(Channel=ECC_GameTraceChannel3,DefaultResponse=ECR_Block,bTraceType=False,bStaticObject=False,Name="Climbable")
+ *
+ * Everything blocks it by default, so Mokosh still bumps into crystals like she did when they were WorldStatic.
+ * Existing content is moved over with the ClimbableCollision commandlet.
+ */
+#define ECC_Climbable ECC_GameTraceChannel3
+
+namespace ClimbingCollision
+{
+	/* True if the component is part of what makes a climbable climbable, as opposed to just visuals*/
+	inline bool IsClimbableCollision(const UPrimitiveComponent* Primitive)
+	{
+		return Primitive->IsRegistered() && Primitive->IsCollisionEnabled() && Primitive->GetCollisionObjectType() == ECC_Climbable;
+	}
+}
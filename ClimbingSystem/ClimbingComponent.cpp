@@ -3,7 +3,6 @@
  */
 
 #include "ClimbingComponent.h"
-#include "Kismet/KismetSystemLibrary.h"
 #include "World/Climbable.h"
 #include "Engine/World.h"
 #include "GameFramework/CharacterMovementComponent.h"
@@ -15,11 +14,41 @@
 #include "Kismet/GameplayStatics.h"
 #include "MasterIncludes.h"
 #include "Utility/ClimbingFunctionLibrary.h"
+#include "ClimbableSubsystem.h"
+#include "ClimbingScoring.h"
+#include "ClimbingCore.h"
+#include "ClimbingStats.h"
+#include "ClimbingCollision.h"
+#include "Misc/ScopeExit.h"
+#include "ClimbingRecorder.h"
+#include "ClimbingPerf.h"
+#include "Containers/Ticker.h"
+#include "GameFramework/GameStateBase.h"
+#include "Net/UnrealNetwork.h"
+
+namespace
+{
+	ClimbingCore::EDetectionType ToClimbingCore(EClimableDetectionTypeEnum DetectionType)
+	{
+		switch (DetectionType)
+		{
+		case CDT_InAir:
+			return ClimbingCore::EDetectionType::InAir;
+		case CDT_ForwardInAir:
+			return ClimbingCore::EDetectionType::ForwardInAir;
+		case CDT_IsClimbing:
+			return ClimbingCore::EDetectionType::IsClimbing;
+		default:
+			return ClimbingCore::EDetectionType::Walking;
+		}
+	}
+}
 
 // Sets default values for this component's properties
 UClimbingComponent::UClimbingComponent()
 {
 	PrimaryComponentTick.bCanEverTick = true;
+	SetIsReplicatedByDefault(true);
 }
 
 
@@ -28,6 +57,36 @@ void UClimbingComponent::BeginPlay()
 {
 	Super::BeginPlay();
 	PlayerRef = Cast<AMokosh>(GetOwner());
+	HangingTransformCache.Reserve(MaxCachedHangingTransforms);
+
+	if (auto ClimbableSubsystem = GetWorld()->GetSubsystem<UClimbableSubsystem>())
+	{
+		ClimbableSubsystem->OnClimbableUnregistered.AddUObject(this, &UClimbingComponent::OnClimbableUnregistered);
+	}
+}
+
+void UClimbingComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	StopClimbingReplay();
+	StopClimbingRecording();
+
+	if (auto ClimbableSubsystem = GetWorld()->GetSubsystem<UClimbableSubsystem>())
+	{
+		ClimbableSubsystem->OnClimbableUnregistered.RemoveAll(this);
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+void UClimbingComponent::OnClimbableUnregistered(const AClimbable* Climbable)
+{
+	HangingTransformCache.Remove(Climbable);
+}
+
+void UClimbingComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(UClimbingComponent, ClimbState);
 }
 
 void UClimbingComponent::Init(UCharacterMovementComponent* ParentCharacterMovement, UCapsuleComponent* ParentCapsule)
@@ -38,6 +97,8 @@ void UClimbingComponent::Init(UCharacterMovementComponent* ParentCharacterMoveme
 
 void UClimbingComponent::ForceInitClimb()
 {
+	CLIMBING_PERF_SCOPE(ClimbPress);
+
 	auto World = GetWorld();
 
 	if (World == nullptr)
@@ -82,34 +143,23 @@ void UClimbingComponent::ForceInitClimb()
 
 		auto Climbable = FindBestClimbable(Direction, ClimbingDetectionType);
 		AttemptClimb(Climbable);
-
-		if (bIsDebugging)
-		{
-			auto HangingTransform = GetHangingPosition(Climbable);
-			UKismetSystemLibrary::DrawDebugCapsule(World,
-			                                       HangingTransform.GetLocation(),
-			                                       CharacterCapsule->GetScaledCapsuleHalfHeight(),
-			                                       CharacterCapsule->GetScaledCapsuleRadius(),
-			                                       HangingTransform.GetRotation().Rotator(),
-			                                       FLinearColor::Green,
-			                                       100.0f);
-		}
 	}
 }
 
 EClimbingDirectionEnum UClimbingComponent::GetDirection(AActor* Origin, AClimbable* Target) const
 {
-	float Result = FVector::DotProduct((Target->GetActorLocation() - Origin->GetActorLocation()).GetSafeNormal(), Origin->GetActorRightVector() * -1.0f);
-	if (Result > ClimbingAnimDotProductDifference)
+	const auto Direction = ClimbingCore::GetDirection(ToClimbingCore(Origin->GetActorLocation()), ToClimbingCore(Origin->GetActorRightVector()),
+		ToClimbingCore(Target->GetActorLocation()), ClimbingAnimDotProductDifference);
+
+	switch (Direction)
 	{
+	case ClimbingCore::EDirection::Left:
 		return EClimbingDirectionEnum::CD_Left;
-	}
-	else if (Result < -ClimbingAnimDotProductDifference)
-	{
+	case ClimbingCore::EDirection::Right:
 		return EClimbingDirectionEnum::CD_Right;
+	default:
+		return EClimbingDirectionEnum::CD_Up;
 	}
-
-	return EClimbingDirectionEnum::CD_Up;
 }
 
 bool UClimbingComponent::AttemptClimb(AClimbable* NewClimbable)
@@ -120,6 +170,31 @@ bool UClimbingComponent::AttemptClimb(AClimbable* NewClimbable)
 		return false;
 	}
 
+	const auto HangingTransform = GetHangingPosition(NewClimbable);
+	if (bSweepJumpPath && IsJumpPathBlocked(NewClimbable, HangingTransform))
+	{
+		return false;
+	}
+
+	// Clients only guess at the jump, the server has the last word and ClimbState tells us if it disagreed
+	if (GetOwnerRole() == ROLE_AutonomousProxy)
+	{
+		ClimbPredictionId++;
+		ServerAttemptClimb(NewClimbable, ClimbPredictionId);
+	}
+
+	StartJump(NewClimbable, HangingTransform);
+	UpdateReplicatedClimbState();
+	return true;
+}
+
+void UClimbingComponent::StartJump(AClimbable* NewClimbable, const FTransform& HangingTransform)
+{
+	if (bUseAdaptiveTick)
+	{
+		WakeUp();
+	}
+
 	PlayerRef->CancelSapAim();
 	PlayerRef->IsClimbJumping = true;
 	PlayerRef->ClimbingDirection = GetDirection(
@@ -129,17 +204,82 @@ bool UClimbingComponent::AttemptClimb(AClimbable* NewClimbable)
 	BeforeMovingPosition = GetOwner()->GetActorLocation();
 	BeforeMovingRotation = GetOwner()->GetActorRotation();
 	NextClimbable = NewClimbable;
+	NumJumpsStarted++;
 	
 	OnGrabbedNewClimbable.Broadcast(NextClimbable);
 
 	CharacterMovement->SetMovementMode(EMovementMode::MOVE_Custom,
 	                                   static_cast<uint8>(ECustomMovementModesEnum::MME_Climbing));
 	MovingTime = 0.0f;
-	
-	return true;
+
+	// Work out everything about the jump that won't change while we're in the air
+	auto ClimbableSubsystem = GetWorld()->GetSubsystem<UClimbableSubsystem>();
+	Jump.Curve.Reset();
+	if (MovementCurve != nullptr && ClimbableSubsystem != nullptr)
+	{
+		Jump.Curve = ClimbableSubsystem->GetCurveTable(MovementCurve);
+	}
+
+	// Moving climbables carry where we'll hang along with them, and the spot we grab on a ledge depends on where we are
+	Jump.bHasFixedEnd = !NewClimbable->bIsMoving && Cast<ASplineLedge>(NewClimbable) == nullptr;
+	Jump.EndLocation = HangingTransform.GetLocation();
+	Jump.EndRotation = HangingTransform.Rotator();
+
+	// HangingTransform hangs off the capsule as it's pitched now, but we'll have turned to the end rotation by the time we get there.
+	// Looked up every tick the end would follow the capsule round to that, so the fixed end has to be where it ends up.
+	if (Jump.bHasFixedEnd)
+	{
+		Jump.EndLocation = ComputeHangingPosition(NewClimbable, HangingTransform.GetRotation().GetUpVector()).GetLocation();
+	}
+}
+
+bool UClimbingComponent::IsJumpPathBlocked(const AClimbable* NewClimbable, const FTransform& HangingTransform)
+{
+	INC_DWORD_STAT(STAT_Climbing_JumpPathSweeps);
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ClimbingJumpPath), /*bTraceComplex: */false, GetOwner());
+	QueryParams.AddIgnoredActor(NewClimbable);
+	if (CurrentClimbable != nullptr)
+	{
+		QueryParams.AddIgnoredActor(CurrentClimbable);
+	}
+
+	JumpPathHits.Reset();
+	GetWorld()->SweepMultiByObjectType(JumpPathHits, GetOwner()->GetActorLocation(), HangingTransform.GetLocation(), GetOwner()->GetActorQuat(),
+		GetObstructionObjectParams(),
+		FCollisionShape::MakeCapsule(CharacterCapsule->GetScaledCapsuleRadius(), CharacterCapsule->GetScaledCapsuleHalfHeight()),
+		QueryParams);
+
+	for (const auto& Hit : JumpPathHits)
+	{
+		// Whatever we're already touching, like the wall we're hanging on, isn't in the way
+		if (Hit.bStartPenetrating)
+		{
+			continue;
+		}
+
+		if (Hit.Component.IsValid() && Hit.Component->GetCollisionResponseToChannel(ECC_MokoshChannel) == ECollisionResponse::ECR_Block)
+		{
+			return true;
+		}
+	}
+
+	return false;
 }
 
 void UClimbingComponent::DetachFromClimbing()
+{
+	if (GetOwnerRole() == ROLE_AutonomousProxy)
+	{
+		ClimbPredictionId++;
+		ServerDetachFromClimbing(ClimbPredictionId);
+	}
+
+	DetachFromClimbingLocally();
+	UpdateReplicatedClimbState();
+}
+
+void UClimbingComponent::DetachFromClimbingLocally()
 {
 	CharacterMovement->SetMovementMode(EMovementMode::MOVE_Falling);
 	PlayerRef->IsDetachClimbing = true;
@@ -147,234 +287,324 @@ void UClimbingComponent::DetachFromClimbing()
 	CharacterMovement->Velocity = FVector::ZeroVector;
 	CurrentClimbable = nullptr;
 	NextClimbable = nullptr;
+	MovingClimbableFollow.Climbable.Reset();
 	auto NewRotation = GetOwner()->GetActorRotation();
 	NewRotation.Roll = 0.0f;
 	NewRotation.Pitch = 0.0f;
 	GetOwner()->SetActorRotation(NewRotation);
 }
 
-AClimbable* UClimbingComponent::FindBestClimbable(FVector2D InputDirection, EClimableDetectionTypeEnum DetectionType)
+AClimbable* UClimbingComponent::FindBestClimbable(FVector2D InputDirection, EClimableDetectionTypeEnum DetectionType,
+                                                  bool bCanWaitForAsyncQueries)
+{
+	CLIMBING_PERF_SCOPE(FindBestClimbable);
+
+	auto BestClimbable = SelectBestClimbable(InputDirection, DetectionType, bCanWaitForAsyncQueries);
+	return RecordBestClimbable(BestClimbable, InputDirection, DetectionType, bCanWaitForAsyncQueries);
+}
+
+AClimbable* UClimbingComponent::RecordBestClimbable(AClimbable* BestClimbable, FVector2D InputDirection,
+                                                    EClimableDetectionTypeEnum DetectionType, bool bCanWaitForAsyncQueries)
+{
+#if WITH_CLIMBING_DEBUG
+	if (DebugSnapshot.IsValid())
+	{
+		DebugSnapshot->Picked = BestClimbable;
+		if (BestClimbable != nullptr)
+		{
+			DebugSnapshot->PickedHangingTransform = GetHangingPosition(BestClimbable);
+		}
+	}
+#endif
+
+	if (Recorder.IsValid())
+	{
+		uint8 Flags = 0;
+		Flags |= bCanWaitForAsyncQueries ? FClimbingRecordedEvent::CRF_CanWaitForAsyncQueries : 0;
+		Flags |= bUseAsyncObstructionQueries ? FClimbingRecordedEvent::CRF_UsedAsyncObstructionQueries : 0;
+		Recorder->RecordQuery(GetRecordedState(), InputDirection, static_cast<uint8>(DetectionType), Flags, BestClimbable);
+	}
+
+	return BestClimbable;
+}
+
+AClimbable* UClimbingComponent::SelectBestClimbable(FVector2D InputDirection, EClimableDetectionTypeEnum DetectionType,
+                                                    bool bCanWaitForAsyncQueries)
 {
+	CLIMBING_SCOPE_CYCLE_COUNTER(STAT_Climbing_FindBestClimbable);
+
 	auto World = GetWorld();
 	if (World == nullptr || bHasPossibleTargets == false || PossibleClimbables.Num() == 0)
 	{
 		return nullptr;
 	}
 
-	FVector Direction = {0, InputDirection.X, InputDirection.Y};
-	
-	auto WorldDirection = UKismetMathLibrary::TransformDirection(GetOwner()->GetActorTransform(), Direction);
-	Direction.Normalize();
-	FTransform DirectionTransform = {WorldDirection.Rotation(), GetOwner()->GetActorLocation()};
-
-	if (bIsDebugging)
+	auto ClimbableSubsystem = World->GetSubsystem<UClimbableSubsystem>();
+	if (ClimbableSubsystem == nullptr || PossibleClimbableSlots.Num() != PossibleClimbables.Num())
 	{
-		UKismetSystemLibrary::DrawDebugArrow(World, GetOwner()->GetActorLocation(),
-		                                     GetOwner()->GetActorLocation() + WorldDirection * 100.0f, 60.0f,
-		                                     FLinearColor::Blue, 20.0f, 5.0f);
+		return nullptr;
 	}
 
-	AClimbable* PossibleClimbable = nullptr;
-	bool bPossibleClimbableIsLedge = false;
-	TArray<float> ClimbableRatings;
+	INC_DWORD_STAT(STAT_Climbing_Queries);
+	INC_DWORD_STAT_BY(STAT_Climbing_Candidates, PossibleClimbables.Num());
+	SET_DWORD_STAT(STAT_Climbing_CandidatesLastQuery, PossibleClimbables.Num());
 
-	for (auto Climbable : PossibleClimbables)
+#if STATS
+	// Only button presses can't wait on async results, so those are the ones we want to know the cost of
+	const auto ObstructionQueriesBefore = NumObstructionQueries;
+	ON_SCOPE_EXIT
 	{
-		int RatingIndex = ClimbableRatings.Add(0.0f);
+		if (!bCanWaitForAsyncQueries)
+		{
+			SET_DWORD_STAT(STAT_Climbing_ObstructionQueriesLastPress, NumObstructionQueries - ObstructionQueriesBefore);
+		}
+	};
+#endif
 
-		FVector LocalPosition = UKismetMathLibrary::InverseTransformLocation(
-			GetOwner()->GetActorTransform(), Climbable->GetActorLocation());
+	FVector Direction = {0, InputDirection.X, InputDirection.Y};
+	
+	const auto OwnerTransform = GetOwner()->GetActorTransform();
+	const auto OwnerLocation = OwnerTransform.GetLocation();
+	const auto OwnerRotation = GetOwner()->GetActorRotation();
+	auto WorldDirection = UKismetMathLibrary::TransformDirection(OwnerTransform, Direction);
+	Direction.Normalize();
+	FTransform DirectionTransform = {WorldDirection.Rotation(), OwnerLocation};
 
-		FVector CurrentLocalPosition;
-		if (CurrentClimbable != nullptr)
+#if WITH_CLIMBING_DEBUG
+	const auto ObstructionQueriesAtStart = NumObstructionQueries;
+	auto Snapshot = DebugSnapshot.Get();
+	if (Snapshot != nullptr)
+	{
+		Snapshot->QueryFrame = GFrameCounter;
+		Snapshot->QueryOrigin = OwnerLocation;
+		Snapshot->QueryDirection = WorldDirection;
+		Snapshot->Picked.Reset();
+		Snapshot->Candidates.Reset();
+		Snapshot->Candidates.SetNum(PossibleClimbables.Num());
+		for (int i = 0; i < PossibleClimbables.Num(); i++)
 		{
-			CurrentLocalPosition = UKismetMathLibrary::InverseTransformLocation(
-				GetOwner()->GetActorTransform(), CurrentClimbable->GetActorLocation());
+			Snapshot->Candidates[i].Climbable = PossibleClimbables[i];
+			Snapshot->Candidates[i].Location = PossibleClimbables[i]->GetActorLocation();
 		}
-
-		FVector PreviousLocalPosition;
-		if (PossibleClimbable != nullptr)
+	}
+	ON_SCOPE_EXIT
+	{
+		if (Snapshot != nullptr)
 		{
-			PreviousLocalPosition = UKismetMathLibrary::InverseTransformLocation(
-				GetOwner()->GetActorTransform(), PossibleClimbable->GetActorLocation());
+			Snapshot->NumObstructionQueries = NumObstructionQueries - ObstructionQueriesAtStart;
 		}
+	};
+#endif
 
+	// We can only grab onto ledges if we're standing on the ground and we don't want to do a ledge check when we're flying forward in air
+	const bool bCanGrabLedges = IsAttached() || IsMovingOnGround();
 
-		if (Climbable->bIsClimbable == false)
-		{
-			continue;
-		}
+	const auto& Mirror = ClimbableSubsystem->GetMirror();
+	AClimbable* PossibleLedge = nullptr;
 
-		// We don't want to check if the player is obstructed when climbing a ledge, we only want to check when on crystals
-		if (IsPlayerCapsuleInsideCollision(Climbable) && Cast<ASplineLedge>(Climbable) == nullptr)
-		{
-			continue;
-		}
+	// First go over the cheap things that need the actual actor, everything else is done on the whole batch at once.
+	// Obstruction checks are left until the very end, since they're by far the most expensive part.
+	ScoringBatch.Reset(PossibleClimbables.Num());
+	for (int i = 0; i < PossibleClimbables.Num(); i++)
+	{
+		auto Climbable = PossibleClimbables[i];
+		const auto Slot = PossibleClimbableSlots[i];
+		const bool bIsLedge = (Mirror.Flags[Slot] & FClimbableMirror::CMF_IsLedge) != 0;
 
-		if (DetectionType == CDT_ForwardInAir)
+		ScoringBatch.PositionX[i] = Mirror.PositionX[Slot];
+		ScoringBatch.PositionY[i] = Mirror.PositionY[Slot];
+		ScoringBatch.PositionZ[i] = Mirror.PositionZ[Slot];
+		ScoringBatch.Yaw[i] = Mirror.Yaw[Slot];
+		ScoringBatch.Pitch[i] = Mirror.Pitch[Slot];
+		ScoringBatch.Eligible[i] = 0.0f;
+
+		if (Climbable->bIsClimbable == false)
 		{
-			// For now we just shouldn't pick this up
-			auto Ledge = Cast<ASplineLedge>(Climbable);
-			if (Ledge != nullptr)
+			INC_DWORD_STAT(STAT_Climbing_RejectedNotClimbable);
+#if WITH_CLIMBING_DEBUG
+			if (Snapshot != nullptr)
 			{
-				continue;
+				Snapshot->Candidates[i].Rejection = EClimbingDebugRejection::NotClimbable;
 			}
+#endif
+			continue;
 		}
-		
-		// We can only grab onto ledges if we're standing on the ground and we don't want to do a ledge check when we're flying forward in air
-		if ((IsAttached() || CharacterMovement->IsMovingOnGround()))
+
+		if (bIsLedge)
 		{
-			auto Ledge = Cast<ASplineLedge>(Climbable);
-			if (Ledge != nullptr)
+			// For now we just shouldn't pick this up
+			if (DetectionType == CDT_ForwardInAir)
 			{
-				auto LedgeTransform = Ledge->GetClimbUpTransform(GetOwner());
-				FVector LocalLedgePosition = UKismetMathLibrary::InverseTransformLocation(
-					GetOwner()->GetActorTransform(), LedgeTransform.GetLocation());
-				if (LedgeTransform.GetLocation().Z < GetOwner()->GetActorLocation().Z)
+				INC_DWORD_STAT(STAT_Climbing_RejectedLedge);
+#if WITH_CLIMBING_DEBUG
+				if (Snapshot != nullptr)
 				{
-					continue;
+					Snapshot->Candidates[i].Rejection = EClimbingDebugRejection::Ledge;
 				}
-				
-				PossibleClimbable = Climbable;
-				bPossibleClimbableIsLedge = true;
+#endif
 				continue;
 			}
-		}
 
-		// We don't want to check for saps directly below us if we're not climbing
-		if (DetectionType != CDT_IsClimbing)
-		{
-			if (Climbable->GetActorLocation().Z < (GetOwner()->GetActorLocation().Z) - CharacterCapsule->GetScaledCapsuleHalfHeight())
+			if (bCanGrabLedges)
 			{
+				auto LedgeTransform = GetLedgeClimbUpTransform(static_cast<ASplineLedge*>(Climbable));
+				if (LedgeTransform.GetLocation().Z >= OwnerLocation.Z)
+				{
+					PossibleLedge = Climbable;
+				}
+				else
+				{
+					INC_DWORD_STAT(STAT_Climbing_RejectedLedge);
+#if WITH_CLIMBING_DEBUG
+					if (Snapshot != nullptr)
+					{
+						Snapshot->Candidates[i].Rejection = EClimbingDebugRejection::Ledge;
+					}
+#endif
+				}
 				continue;
 			}
 		}
 
-		// If we already have a ledge, then we don't need to go any further
-		if (bPossibleClimbableIsLedge)
-		{
-			continue;
-		}
+		ScoringBatch.Eligible[i] = 1.0f;
+	}
 
-		// If it's behind us, we can't climb onto it.
-		// We don't really need to preform this check while we're climbing
-		if (DetectionType != CDT_ForwardInAir)
-		{
-			if (!IsAttached())
-			{
-				if (LocalPosition.X < 0)
-				{
-					continue;
-				}
-			}
-		}
+	// If we've already got a ledge, don't bother looking at any of the other options
+	if (PossibleLedge != nullptr)
+	{
+		return PossibleLedge;
+	}
 
-		// If we're attempting to auto climb on wall, then we want a different distance than usual
-		if (DetectionType == CDT_ForwardInAir)
+	ClimbingCore::FScoringInputs ScoringInputs;
+	ScoringInputs.DetectionType = ToClimbingCore(DetectionType);
+	ScoringInputs.bIsAttached = IsAttached();
+	ScoringInputs.bIsOnGround = CharacterState == ECharacterStateEnum::CCS_OnGround;
+	ScoringInputs.Origin = ToClimbingCore(OwnerLocation);
+	ScoringInputs.LocalAxisX = ToClimbingCore(
+		OwnerTransform.GetUnitAxis(EAxis::X) * FTransform::GetSafeScaleReciprocal(OwnerTransform.GetScale3D()).X);
+	ScoringInputs.DirectionAxisX = ToClimbingCore(DirectionTransform.GetUnitAxis(EAxis::X));
+	ScoringInputs.DirectionAxisY = ToClimbingCore(DirectionTransform.GetUnitAxis(EAxis::Y));
+	ScoringInputs.OwnerYaw = OwnerRotation.Yaw;
+	ScoringInputs.OwnerPitch = OwnerRotation.Pitch;
+	ScoringInputs.CapsuleHalfHeight = CharacterCapsule->GetScaledCapsuleHalfHeight();
+	ScoringInputs.MaxForwardGroundJumpDistance = MaxForwardGroundJumpDistance;
+	ScoringInputs.MaxForwardThrownDistance = MaxForwardThrownDistance;
+	ScoringInputs.MaxYawDelta = MaxYRotation;
+	ScoringInputs.MaxPitchDelta = MaxYRotation;
+
+	ClimbingScoring::ScoreCandidates(ClimbingCore::MakeScoringParams(ScoringInputs), ScoringBatch);
+
+#if STATS
+	for (int i = 0; i < PossibleClimbables.Num(); i++)
+	{
+		if (ScoringBatch.Eligible[i] != 0.0f && ScoringBatch.Ratings[i] <= 0.0f)
 		{
-			if (LocalPosition.X > MaxForwardThrownDistance)
-			{
-				continue;
-			}	
+			INC_DWORD_STAT(STAT_Climbing_RejectedByFilters);
 		}
-		else
+	}
+#endif
+
+#if WITH_CLIMBING_DEBUG
+	if (Snapshot != nullptr)
+	{
+		for (int i = 0; i < PossibleClimbables.Num(); i++)
 		{
-			// Even though we do a circle cast, we don't want the player to be able to reach the full extent of the 
-			if (CharacterState == ECharacterStateEnum::CCS_OnGround && LocalPosition.X > MaxForwardGroundJumpDistance)
+			auto& Candidate = Snapshot->Candidates[i];
+			Candidate.Rating = ScoringBatch.Ratings[i];
+			if (ScoringBatch.Eligible[i] != 0.0f && ScoringBatch.Ratings[i] <= 0.0f)
 			{
-				continue;
+				Candidate.Rejection = EClimbingDebugRejection::Filters;
 			}
 		}
+	}
+#endif
 
-		// Fancy directional check
-
-		// We want to create a Transform based on the direction and then for each of the saps compare the forward direction
-		auto RelativeSapPos = UKismetMathLibrary::InverseTransformLocation(
-			DirectionTransform, Climbable->GetActorLocation());
-
-		if (DetectionType != CDT_ForwardInAir)
+	// The region has to hold the hanging capsule of every candidate that could still be picked
+	ObstructionBatch.Reset();
+	ON_SCOPE_EXIT
+	{
+		ObstructionBatch.Reset();
+	};
+	if (bUseBatchedObstructionQueries)
+	{
+		for (int i = 0; i < PossibleClimbables.Num(); i++)
 		{
-			if (RelativeSapPos.X <= 0)
+			if (ScoringBatch.Ratings[i] > 0.0f)
 			{
-				continue;
+				ObstructionBatch.Region += FVector(ScoringBatch.PositionX[i], ScoringBatch.PositionY[i], ScoringBatch.PositionZ[i]);
 			}
 		}
 
-		auto ZRot = FMath::FindDeltaAngleDegrees(GetOwner()->GetActorRotation().Yaw, Climbable->GetActorRotation().Yaw);
-		if (ZRot > MaxYRotation)
+		if (ObstructionBatch.Region.IsValid)
 		{
-			continue;
+			const auto HalfHeight = CharacterCapsule->GetScaledCapsuleHalfHeight();
+			const auto MaxHangingOffset = FMath::Abs(DistanceFromClimbTarget.X) + FMath::Abs(DistanceFromClimbTarget.Z + HalfHeight);
+			ObstructionBatch.Region = ObstructionBatch.Region.ExpandBy(MaxHangingOffset + HalfHeight);
 		}
+	}
+
+	// Go through the candidates from best to worst, the first one we actually fit at is the one we want.
+	// Most of the time this is the first one, so we only end up doing one or two overlap queries.
+	ClimbingScoring::BuildCandidateHeap(ScoringBatch, CandidateHeap);
+	for (auto CandidateIndex = ClimbingScoring::PopBestCandidate(ScoringBatch, CandidateHeap);
+	     CandidateIndex != INDEX_NONE;
+	     CandidateIndex = ClimbingScoring::PopBestCandidate(ScoringBatch, CandidateHeap))
+	{
+		auto Climbable = PossibleClimbables[CandidateIndex];
+		const auto Flags = Mirror.Flags[PossibleClimbableSlots[CandidateIndex]];
 
-		auto YRot = FMath::FindDeltaAngleDegrees(GetOwner()->GetActorRotation().Pitch, Climbable->GetActorRotation().Pitch);
-		if (YRot > MaxYRotation)
+#if WITH_CLIMBING_DEBUG
+		auto DebugCandidate = Snapshot != nullptr ? &Snapshot->Candidates[CandidateIndex] : nullptr;
+		if (DebugCandidate != nullptr)
 		{
-			continue;
+			DebugCandidate->Rejection = EClimbingDebugRejection::None;
+			Snapshot->LastObstructedBy.Reset();
 		}
+#endif
 
-		ClimbableRatings[RatingIndex] = 1.0f;
-
-		
-		// Magical formula for deciding best climbable
-		if (DetectionType != CDT_ForwardInAir)
+		// We don't want to check if the player is obstructed when climbing a ledge, we only want to check when on crystals
+		if ((Flags & FClimbableMirror::CMF_IsLedge) != 0)
 		{
-			// We prefer going towards the positive X direction, and any saps that are farther to the left or right are not preferred
-			ClimbableRatings[RatingIndex] += RelativeSapPos.X * 0.5f;
-			ClimbableRatings[RatingIndex] -= FMath::Abs(RelativeSapPos.Y) * 0.1f;
+			return Climbable;
 		}
-		else
+
+		// Static climbables in the baked graph were checked for obstructions when it was baked
+		if (CandidateIndex < NumBakedCandidates && (Flags & FClimbableMirror::CMF_IsMoving) == 0)
 		{
-			// If we're going forward in air, then the center is actually the preferred position
-			ClimbableRatings[RatingIndex] = 60;
-			ClimbableRatings[RatingIndex] -= FMath::Abs(RelativeSapPos.X) * 0.1f;
-			ClimbableRatings[RatingIndex] -= FMath::Abs(RelativeSapPos.Y) * 0.1f;
+			return Climbable;
 		}
-	}
-	// If we've already got a ledge, don't bother looking at any of the other options
-	if (bPossibleClimbableIsLedge)
-	{
-		return PossibleClimbable;
-	}
-	
-	int PossibleGoodClimableIndex = -1;
-	for (int i = 0; i < PossibleClimbables.Num(); i++)
-	{
-		if (bIsDebugging)
+
+		const auto Obstruction = GetObstruction(Climbable, bCanWaitForAsyncQueries);
+		if (Obstruction == EObstructionResult::Clear)
 		{
-			if (FMath::RoundToInt(ClimbableRatings[i]) != -9999)
-			{
-				UKismetSystemLibrary::DrawDebugString(World, PossibleClimbables[i]->GetActorLocation(),
-					FString::Printf(TEXT("%d"), FMath::RoundToInt(ClimbableRatings[i])), nullptr,
-					FLinearColor::Blue, 5.0f);
-			}
+			return Climbable;
 		}
-		
-		if (PossibleGoodClimableIndex == -1)
+
+#if WITH_CLIMBING_DEBUG
+		if (DebugCandidate != nullptr)
 		{
-			if (ClimbableRatings[i] > 0)
-			{
-				PossibleGoodClimableIndex = i;
-			}
+			DebugCandidate->Rejection = Obstruction == EObstructionResult::Pending
+				? EClimbingDebugRejection::Pending
+				: EClimbingDebugRejection::Obstructed;
+			DebugCandidate->ObstructedBy = Snapshot->LastObstructedBy;
 		}
-		else if (ClimbableRatings[i] > ClimbableRatings[PossibleGoodClimableIndex])
+#endif
+
+		// We don't know yet if the best option is free, and we don't want to settle for a worse one, so wait for the result
+		if (Obstruction == EObstructionResult::Pending)
 		{
-			PossibleGoodClimableIndex = i;
+			return nullptr;
 		}
-	}
 
-	if (PossibleGoodClimableIndex != -1)
-	{
-		return PossibleClimbables[PossibleGoodClimableIndex];
-	}
-	else
-	{
-		return nullptr;
+		INC_DWORD_STAT(STAT_Climbing_RejectedObstructed);
 	}
+
+	return nullptr;
 }
 
 FTransform UClimbingComponent::GetHangingPosition(const AActor* NewClimbable)
 {
-	auto World = GetWorld();
+	CLIMBING_SCOPE_CYCLE_COUNTER(STAT_Climbing_GetHangingPosition);
 
 	if (NewClimbable == nullptr)
 	{
@@ -382,46 +612,97 @@ FTransform UClimbingComponent::GetHangingPosition(const AActor* NewClimbable)
 		return FTransform{};
 	}
 
-	auto BaseLoc = NewClimbable->GetActorLocation();
-	auto Ledge = Cast<ASplineLedge>(NewClimbable);
-
-	if (Ledge != nullptr)
+	// Ledges depend on where we are along them and moving climbables change every frame, so only static crystals get cached
+	auto Climbable = Cast<AClimbable>(NewClimbable);
+	if (Climbable == nullptr || Climbable->bIsMoving || Cast<ASplineLedge>(NewClimbable) != nullptr)
 	{
-		BaseLoc = Ledge->GetClimbUpTransform(GetOwner()).GetLocation();
+		return ComputeHangingPosition(NewClimbable);
 	}
 
-	auto HangingVerticalLocalPosition = CharacterCapsule->GetUpVector() * (DistanceFromClimbTarget.Z + CharacterCapsule
-		->GetScaledCapsuleHalfHeight());
-	auto HorizontalDirection = NewClimbable->GetActorForwardVector() * DistanceFromClimbTarget.X;
+	const auto CapsuleUp = CharacterCapsule->GetUpVector();
+	const auto CapsuleHalfHeight = CharacterCapsule->GetScaledCapsuleHalfHeight();
+	const auto CapsuleRadius = CharacterCapsule->GetScaledCapsuleRadius();
+	const auto& ClimbableTransform = NewClimbable->GetActorTransform();
 
-	if (Ledge != nullptr)
+	// Only the climbables around us are worth keeping, starting over once it's full is cheaper than tracking which are stale
+	if (HangingTransformCache.Num() >= MaxCachedHangingTransforms && !HangingTransformCache.Contains(NewClimbable))
 	{
-		HorizontalDirection = Ledge->GetClimbUpTransform(GetOwner()).Rotator().Vector() * -DistanceFromClimbTarget.X;
+		HangingTransformCache.Reset();
 	}
-
-	FTransform Result;
-	Result.SetLocation((BaseLoc - HangingVerticalLocalPosition) + HorizontalDirection);
-	
-	if (Ledge == nullptr)
+	auto& CachedTransform = HangingTransformCache.FindOrAdd(NewClimbable);
+	if (CachedTransform.Climbable.Get() != NewClimbable ||
+		!CachedTransform.ClimbableTransform.Equals(ClimbableTransform, 0.0f) ||
+		CachedTransform.CapsuleHalfHeight != CapsuleHalfHeight ||
+		CachedTransform.CapsuleRadius != CapsuleRadius ||
+		CachedTransform.DistanceFromClimbTarget != DistanceFromClimbTarget ||
+		!CachedTransform.CapsuleUp.Equals(CapsuleUp, KINDA_SMALL_NUMBER))
 	{
-		Result.SetRotation(NewClimbable->GetActorForwardVector().Rotation().Quaternion());
+		CachedTransform.Climbable = NewClimbable;
+		CachedTransform.ClimbableTransform = ClimbableTransform;
+		CachedTransform.CapsuleUp = CapsuleUp;
+		CachedTransform.CapsuleHalfHeight = CapsuleHalfHeight;
+		CachedTransform.CapsuleRadius = CapsuleRadius;
+		CachedTransform.DistanceFromClimbTarget = DistanceFromClimbTarget;
+		CachedTransform.Transform = ComputeHangingPosition(NewClimbable);
+		INC_DWORD_STAT(STAT_Climbing_HangingCacheMisses);
 	}
 	else
 	{
-		if (bIsDebugging)
-		{
-			UKismetSystemLibrary::DrawDebugArrow(World, BaseLoc,
-			                                     BaseLoc + ((Ledge->GetClimbUpTransform(GetOwner()).Rotator().Vector() *
-				                                     -1.0f).Rotation().Quaternion().Vector() * 200),
-			                                     10, FLinearColor::Green, 10.0f);
-		}
-		Result.SetRotation((Ledge->GetClimbUpTransform(GetOwner()).Rotator().Vector() * -1.0f).Rotation().Quaternion());
+		INC_DWORD_STAT(STAT_Climbing_HangingCacheHits);
+	}
+
+	return CachedTransform.Transform;
+}
+
+FTransform UClimbingComponent::ComputeHangingPosition(const AActor* NewClimbable)
+{
+	return ComputeHangingPosition(NewClimbable, CharacterCapsule->GetUpVector());
+}
+
+FTransform UClimbingComponent::ComputeHangingPosition(const AActor* NewClimbable, const FVector& CapsuleUp)
+{
+	auto BaseLoc = NewClimbable->GetActorLocation();
+	auto Facing = NewClimbable->GetActorForwardVector();
+	auto Ledge = Cast<ASplineLedge>(NewClimbable);
+
+	// On ledges we face away from the direction we'd climb up in
+	if (Ledge != nullptr)
+	{
+		const auto LedgeTransform = GetLedgeClimbUpTransform(Ledge);
+		BaseLoc = LedgeTransform.GetLocation();
+		Facing = LedgeTransform.Rotator().Vector() * -1.0f;
 	}
+
+	const auto Pose = ClimbingCore::GetHangingPose(ToClimbingCore(BaseLoc), ToClimbingCore(Facing),
+		ToClimbingCore(CapsuleUp), CharacterCapsule->GetScaledCapsuleHalfHeight(),
+		DistanceFromClimbTarget.X, DistanceFromClimbTarget.Z);
+
+	FTransform Result;
+	Result.SetLocation(FromClimbingCore(Pose.Location));
+	Result.SetRotation(FRotator(Pose.Pitch, Pose.Yaw, 0.0f).Quaternion());
 	return Result;
 }
 
+FTransform UClimbingComponent::GetLedgeClimbUpTransform(const ASplineLedge* Ledge) const
+{
+	auto World = GetWorld();
+	auto ClimbableSubsystem = World != nullptr ? World->GetSubsystem<UClimbableSubsystem>() : nullptr;
+	if (ClimbableSubsystem == nullptr)
+	{
+		return Ledge->GetClimbUpTransform(GetOwner());
+	}
+
+	return ClimbableSubsystem->GetClimbUpTransform(Ledge, GetOwner());
+}
+
 void UClimbingComponent::CalculateCharacterState()
 {
+	// Replays set the state straight from the recording
+	if (Replay.IsValid())
+	{
+		return;
+	}
+
 	if (CharacterMovement->IsMovingOnGround() && !IsClimbing())
 	{
 		if (PlayerRef != nullptr && CharacterState != ECharacterStateEnum::CCS_OnGround)
@@ -454,30 +735,58 @@ void UClimbingComponent::AutoGrabChecker()
 {
 	if (bIsFlyingForwardInAir && bHasPossibleTargets)
 	{
-		auto Direction = FVector2D(0, 1);
-		auto Climbable = FindBestClimbable(Direction, CDT_ForwardInAir);
+		auto Climbable = FindBestForwardInAirClimbable();
 		AttemptClimb(Climbable);
 	}
 }
 
+AClimbable* UClimbingComponent::FindBestForwardInAirClimbable()
+{
+	auto Direction = FVector2D(0, 1);
+	if (TickCommands.bHasForwardPick && TickCommands.ForwardPickJumpNumber == NumJumpsStarted)
+	{
+		// Another climber's ApplyTick can destroy it in the batched tick, we'll have another look next tick
+		auto Climbable = TickCommands.ForwardPick;
+		if (Climbable != nullptr && Climbable->IsPendingKill())
+		{
+			Climbable = nullptr;
+		}
+		return RecordBestClimbable(Climbable, Direction, CDT_ForwardInAir, /*bCanWaitForAsyncQueries: */true);
+	}
+
+	// Being a frame late on an auto grab isn't noticeable, so we're fine waiting on async results here
+	return FindBestClimbable(Direction, CDT_ForwardInAir, /*bCanWaitForAsyncQueries: */true);
+}
+
 void UClimbingComponent::DetectClimbables()
 {
+	CalculateCharacterState();
+	GatherClimbables(bIsFlyingForwardInAir);
+}
+
+void UClimbingComponent::GatherClimbables(bool bFlyingForwardInAir)
+{
+	CLIMBING_SCOPE_CYCLE_COUNTER(STAT_Climbing_DetectClimbables);
+	CLIMBING_PERF_SCOPE(DetectClimbables);
+
 	auto World = GetWorld();
 	if (World == nullptr)
 	{
 		return;
 	}
 
-	CalculateCharacterState();
-
-	const TArray<TEnumAsByte<EObjectTypeQuery>> ObjectTypes =
+	auto ClimbableSubsystem = World->GetSubsystem<UClimbableSubsystem>();
+	if (ClimbableSubsystem == nullptr)
 	{
-		UEngineTypes::ConvertToObjectType(ECollisionChannel::ECC_WorldStatic),
-		UEngineTypes::ConvertToObjectType(ECollisionChannel::ECC_WorldDynamic),
-	};
+		// Nothing can be found without the index, so don't leave last tick's candidates around to be grabbed
+		bHasPossibleTargets = false;
+		PossibleClimbables.Reset();
+		PossibleClimbableSlots.Reset();
+		NumBakedCandidates = 0;
+		return;
+	}
 
-	const TArray<AActor*> IgnoreList = {CurrentClimbable, NextClimbable};
-	TArray<AActor*> OutActors = {};
+	const TArray<AActor*, TInlineAllocator<2>> IgnoreList = {CurrentClimbable, NextClimbable};
 
 	FVector CastTarget = GetOwner()->GetActorLocation();
 	if (IsAttached())
@@ -495,141 +804,1279 @@ void UClimbingComponent::DetectClimbables()
 		DetectionRadius = InAirClimbingDetectionRadius;
 	}
 
-	// Only used if bIsFlyingForwardInAir is set
+	// Only used if bFlyingForwardInAir is set
 	auto FlyingForwardCastPosition = GetOwner()->GetActorLocation() + CapsuleOffset;
 	bool bIsOverlapped = false;
 
-	if (bIsFlyingForwardInAir)
+	// The climbable index only holds climbables, so we don't need to go through the physics scene for any of this
+	bDetectedFromGraph = false;
+	NumBakedCandidates = 0;
+	if (bFlyingForwardInAir && bUsePredictivePrefetch)
 	{
-		auto FlyingForwardCastPosition = GetOwner()->GetActorLocation() + CapsuleOffset;
-		bIsOverlapped = UKismetSystemLibrary::CapsuleOverlapActors(World, FlyingForwardCastPosition, FlyingForwardCapsuleRadius, 
-			FlyingForwardCapsuleHeight * 0.5f, ObjectTypes, AClimbable::StaticClass(), IgnoreList, OutActors);
+		bIsOverlapped = DetectClimbablesPredictive(ClimbableSubsystem, FlyingForwardCastPosition, IgnoreList);
 	}
-	else
+	else if (bFlyingForwardInAir)
 	{
-		bIsOverlapped = UKismetSystemLibrary::SphereOverlapActors(World, CastTarget, DetectionRadius, ObjectTypes,
-		                                                               AClimbable::StaticClass(), IgnoreList, OutActors);
+		bIsOverlapped = ClimbableSubsystem->QueryCapsule(FlyingForwardCastPosition, FlyingForwardCapsuleRadius,
+			FlyingForwardCapsuleHeight * 0.5f, IgnoreList, PossibleClimbables, &PossibleClimbableSlots);
 	}
-
-	if (bIsOverlapped)
+	else if (bUseBakedClimbingGraph && IsAttached() && !CurrentClimbable->bIsMoving &&
+		ClimbableSubsystem->GetBakedNeighbours(CurrentClimbable, DetectionRadius, IgnoreList, PossibleClimbables, &PossibleClimbableSlots))
+	{
+		// Moving climbables were never baked and neither was anything across a level seam, so those still have to be looked for
+		NumBakedCandidates = PossibleClimbables.Num();
+		ClimbableSubsystem->AppendUnbakedInSphere(CurrentClimbable, CastTarget, DetectionRadius, IgnoreList, PossibleClimbables,
+			&PossibleClimbableSlots);
+		bDetectedFromGraph = true;
+		bIsOverlapped = PossibleClimbables.Num() > 0;
+		INC_DWORD_STAT(STAT_Climbing_GraphDetections);
+	}
+	else if (bUseIncrementalDetection)
+	{
+		bIsOverlapped = DetectClimbablesIncremental(ClimbableSubsystem, CastTarget, DetectionRadius, IgnoreList);
+	}
+	else
+	{
+		bIsOverlapped = QueryClimbableSphere(ClimbableSubsystem, CastTarget, DetectionRadius, IgnoreList, PossibleClimbables,
+			&PossibleClimbableSlots);
+	}
+
+	if (bIsOverlapped)
 	{
 		bHasPossibleTargets = true;
-		PossibleClimbables = ConvertArrayToClimbable(OutActors);
-		if (bIsDebugging)
+	}
+	else
+	{
+		bHasPossibleTargets = false;
+		PossibleClimbables.Reset();
+		PossibleClimbableSlots.Reset();
+		NumBakedCandidates = 0;
+	}
+
+#if WITH_CLIMBING_DEBUG
+	if (DebugSnapshot.IsValid())
+	{
+		DebugSnapshot->bDetectedAny = bIsOverlapped;
+		DebugSnapshot->bDetectedWithCapsule = bFlyingForwardInAir;
+		DebugSnapshot->DetectionCenter = bFlyingForwardInAir ? FlyingForwardCastPosition : CastTarget;
+		DebugSnapshot->DetectionRadius = bFlyingForwardInAir ? FlyingForwardCapsuleRadius : DetectionRadius;
+		DebugSnapshot->DetectionHalfHeight = FlyingForwardCapsuleHeight * 0.5f;
+
+		if (bFlyingForwardInAir)
+		{
+			DebugSnapshot->DetectionSource = bUsePredictivePrefetch ? TEXT("Predicted arc") : TEXT("Capsule");
+		}
+		else if (bDetectedFromGraph)
+		{
+			DebugSnapshot->DetectionSource = TEXT("Baked graph");
+		}
+		else
+		{
+			DebugSnapshot->DetectionSource = bUseIncrementalDetection ? TEXT("Incremental sphere") : TEXT("Sphere");
+		}
+	}
+#endif
+}
+
+FVector UClimbingComponent::FTrajectoryPrefetch::GetPredictedLocation(float Time) const
+{
+	const auto Elapsed = Time - StartTime;
+	return StartLocation + StartVelocity * Elapsed + FVector(0.0f, 0.0f, 0.5f * GravityZ * Elapsed * Elapsed);
+}
+
+void UClimbingComponent::UpdateTrajectoryPrefetch(UClimbableSubsystem* ClimbableSubsystem, const FVector& CastPosition,
+                                                  TArrayView<AActor* const> IgnoreList)
+{
+	const auto Now = GetWorld()->GetTimeSeconds();
+	const auto LookAhead = GetWorld()->GetDeltaSeconds();
+
+	// Still good as long as we're where it said we'd be, and it reaches past the next tick
+	auto& Prefetch = TrajectoryPrefetch;
+	if (Prefetch.bIsValid && Prefetch.Generation == ClimbableSubsystem->GetGeneration() &&
+		Now + LookAhead <= Prefetch.StartTime + Prefetch.Duration &&
+		FVector::DistSquared(Prefetch.GetPredictedLocation(Now), CastPosition) <= FMath::Square(PredictivePrefetchTolerance))
+	{
+		return;
+	}
+
+	INC_DWORD_STAT(STAT_Climbing_TrajectoryPrefetches);
+
+	Prefetch.StartLocation = CastPosition;
+	Prefetch.StartVelocity = CharacterMovement->Velocity;
+	Prefetch.GravityZ = CharacterMovement->GetGravityZ();
+	Prefetch.StartTime = Now;
+	Prefetch.Duration = FMath::Max(PredictivePrefetchTime, LookAhead);
+	Prefetch.Generation = ClimbableSubsystem->GetGeneration();
+	Prefetch.bIsValid = true;
+
+	TrajectoryPoints.Reset();
+	for (int32 i = 0; i <= PredictivePrefetchSteps; i++)
+	{
+		TrajectoryPoints.Add(Prefetch.GetPredictedLocation(Now + Prefetch.Duration * i / PredictivePrefetchSteps));
+	}
+
+	ClimbableSubsystem->QueryPath(TrajectoryPoints, FlyingForwardCapsuleRadius, FlyingForwardCapsuleHeight * 0.5f, IgnoreList,
+		Prefetch.Climbables, &Prefetch.Slots, &Prefetch.Bounds);
+}
+
+bool UClimbingComponent::DetectClimbablesPredictive(UClimbableSubsystem* ClimbableSubsystem, const FVector& CastPosition,
+                                                    TArrayView<AActor* const> IgnoreList)
+{
+	UpdateTrajectoryPrefetch(ClimbableSubsystem, CastPosition, IgnoreList);
+
+	// Everywhere we'll be between now and the next tick, so a climbable we'd fly straight through still gets picked up
+	const auto Now = GetWorld()->GetTimeSeconds();
+	const auto NextCastPosition = CastPosition +
+		TrajectoryPrefetch.GetPredictedLocation(Now + GetWorld()->GetDeltaSeconds()) - TrajectoryPrefetch.GetPredictedLocation(Now);
+	const auto HalfHeight = FlyingForwardCapsuleHeight * 0.5f;
+
+	PossibleClimbables.Reset();
+	PossibleClimbableSlots.Reset();
+
+	const auto& Mirror = ClimbableSubsystem->GetMirror();
+	for (int32 i = 0; i < TrajectoryPrefetch.Climbables.Num(); i++)
+	{
+		auto Climbable = TrajectoryPrefetch.Climbables[i];
+		const auto Slot = TrajectoryPrefetch.Slots[i];
+
+		// Moving ones have moved on since they were gathered, those get looked for fresh below
+		if ((Mirror.Flags[Slot] & FClimbableMirror::CMF_IsMoving) != 0 || IgnoreList.Contains(Climbable))
+		{
+			continue;
+		}
+
+		if (UClimbableSubsystem::DoesSweptCapsuleTouchBox(TrajectoryPrefetch.Bounds[i], CastPosition, NextCastPosition,
+			FlyingForwardCapsuleRadius, HalfHeight))
+		{
+			PossibleClimbables.Add(Climbable);
+			PossibleClimbableSlots.Add(Slot);
+		}
+	}
+
+	ClimbableSubsystem->AppendMovingInSphere((CastPosition + NextCastPosition) * 0.5f,
+		FMath::Max(FlyingForwardCapsuleRadius, HalfHeight) + FVector::Dist(CastPosition, NextCastPosition) * 0.5f,
+		IgnoreList, PossibleClimbables, &PossibleClimbableSlots);
+
+	return PossibleClimbables.Num() > 0;
+}
+
+bool UClimbingComponent::QueryClimbableSphere(UClimbableSubsystem* ClimbableSubsystem, const FVector& Center, float Radius,
+                                              TArrayView<AActor* const> IgnoreList, TArray<AClimbable*>& OutClimbables,
+                                              TArray<int32>* OutSlots, TArray<FBox>* OutBounds) const
+{
+	if (bUseSharedDetection)
+	{
+		return ClimbableSubsystem->QuerySphereShared(Center, Radius, IgnoreList, OutClimbables, OutSlots, OutBounds);
+	}
+
+	return ClimbableSubsystem->QuerySphere(Center, Radius, IgnoreList, OutClimbables, OutSlots, OutBounds);
+}
+
+bool UClimbingComponent::DetectClimbablesIncremental(UClimbableSubsystem* ClimbableSubsystem, const FVector& CastTarget,
+                                                     float DetectionRadius, TArrayView<AActor* const> IgnoreList)
+{
+	const auto RefreshDistance = DetectionRadius * IncrementalDetectionRefreshFraction;
+
+	bool bNeedsRefresh = !DetectionCache.bIsValid ||
+		DetectionCache.Radius != DetectionRadius ||
+		DetectionCache.CharacterState != CharacterState ||
+		DetectionCache.IgnoredCurrentClimbable != CurrentClimbable ||
+		DetectionCache.IgnoredNextClimbable != NextClimbable ||
+		DetectionCache.Generation != ClimbableSubsystem->GetGeneration() ||
+		FVector::DistSquared(DetectionCache.Origin, CastTarget) > FMath::Square(RefreshDistance);
+
+	if (!bNeedsRefresh)
+	{
+		// Moving climbables can come into or leave the cached area at any time, so we can't trust the cache around them
+		for (auto Climbable : DetectionCache.Climbables)
+		{
+			if (Climbable == nullptr || Climbable->bIsMoving)
+			{
+				bNeedsRefresh = true;
+				break;
+			}
+		}
+	}
+
+	if (!bNeedsRefresh)
+	{
+		bNeedsRefresh = ClimbableSubsystem->IsMovingClimbableInBox(
+			FBox::BuildAABB(DetectionCache.Origin, FVector(DetectionCache.QueryRadius)));
+	}
+
+	if (bNeedsRefresh)
+	{
+		INC_DWORD_STAT(STAT_Climbing_DetectionCacheMisses);
+
+		DetectionCache.Origin = CastTarget;
+		DetectionCache.Radius = DetectionRadius;
+		DetectionCache.QueryRadius = DetectionRadius + RefreshDistance;
+		DetectionCache.CharacterState = CharacterState;
+		DetectionCache.IgnoredCurrentClimbable = CurrentClimbable;
+		DetectionCache.IgnoredNextClimbable = NextClimbable;
+		DetectionCache.Generation = ClimbableSubsystem->GetGeneration();
+		DetectionCache.bIsValid = true;
+
+		QueryClimbableSphere(ClimbableSubsystem, CastTarget, DetectionCache.QueryRadius, IgnoreList,
+			DetectionCache.Climbables, &DetectionCache.Slots, &DetectionCache.Bounds);
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_Climbing_DetectionCacheHits);
+	}
+
+	// Anything that's outside of the cached query radius is also outside the detection radius, as long as we haven't
+	// moved further than the refresh distance. So this gives the same result as doing the actual query.
+	const auto RadiusSquared = FMath::Square(DetectionRadius);
+	PossibleClimbables.Reset();
+	PossibleClimbableSlots.Reset();
+	for (int i = 0; i < DetectionCache.Climbables.Num(); i++)
+	{
+		if (DetectionCache.Bounds[i].ComputeSquaredDistanceToPoint(CastTarget) <= RadiusSquared)
+		{
+			PossibleClimbables.Add(DetectionCache.Climbables[i]);
+			PossibleClimbableSlots.Add(DetectionCache.Slots[i]);
+		}
+	}
+
+	return PossibleClimbables.Num() > 0;
+}
+
+bool UClimbingComponent::IsPlayerCapsuleInsideCollision(AActor* Climbable)
+{
+	CLIMBING_SCOPE_CYCLE_COUNTER(STAT_Climbing_IsPlayerCapsuleInsideCollision);
+
+	auto World = GetWorld();
+	if (World == nullptr)
+	{
+		return false;
+	}
+
+	// Moving climbables carry the capsule somewhere new every frame, there's nothing to remember
+	auto ClimbableSubsystem = World->GetSubsystem<UClimbableSubsystem>();
+	auto AsClimbable = Cast<AClimbable>(Climbable);
+	if (!bUseObstructionCache || (AsClimbable != nullptr && AsClimbable->bIsMoving))
+	{
+		ClimbableSubsystem = nullptr;
+	}
+
+	const auto HangingTransform = GetHangingPosition(Climbable);
+	const auto Capsule = FCollisionShape::MakeCapsule(CharacterCapsule->GetScaledCapsuleRadius(), CharacterCapsule->GetScaledCapsuleHalfHeight());
+
+	bool bIsObstructed;
+	if (ClimbableSubsystem != nullptr && ClimbableSubsystem->FindCachedObstruction(Climbable, HangingTransform, Capsule, bIsObstructed))
+	{
+		return bIsObstructed;
+	}
+
+	if (ObstructionBatch.Region.IsValid)
+	{
+		bIsObstructed = IsCapsuleObstructedInBatch(HangingTransform, Capsule);
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_Climbing_ObstructionQueries);
+		NumObstructionQueries++;
+		bIsObstructed = IsCapsuleObstructedAt(HangingTransform);
+	}
+
+	if (ClimbableSubsystem != nullptr)
+	{
+		ClimbableSubsystem->CacheObstruction(Climbable, HangingTransform, Capsule, bIsObstructed);
+	}
+	return bIsObstructed;
+}
+
+bool UClimbingComponent::IsCapsuleObstructedAt(const FTransform& Transform)
+{
+	// The overlap array is kept around so that it's only ever as big as the busiest spot we've checked
+	ObstructionOverlaps.Reset();
+	GetWorld()->OverlapMultiByObjectType(ObstructionOverlaps, Transform.GetLocation(), Transform.GetRotation(), GetObstructionObjectParams(),
+		FCollisionShape::MakeCapsule(CharacterCapsule->GetScaledCapsuleRadius(), CharacterCapsule->GetScaledCapsuleHalfHeight()));
+
+	return IsAnyOverlapBlocking(ObstructionOverlaps);
+}
+
+void UClimbingComponent::FObstructionBatch::Reset()
+{
+	Region = FBox(ForceInit);
+	Primitives.Reset();
+	Bounds.Reset();
+	bIsGathered = false;
+}
+
+bool UClimbingComponent::IsCapsuleObstructedInBatch(const FTransform& Transform, const FCollisionShape& Capsule)
+{
+	// Whichever way the capsule is turned, it fits in here
+	const auto CapsuleBounds = FBox::BuildAABB(Transform.GetLocation(), FVector(Capsule.GetCapsuleHalfHeight()));
+
+	// The batch only has what's inside the region, anything sticking out of it might hit something that wasn't gathered
+	if (!ObstructionBatch.Region.IsInsideOrOn(CapsuleBounds.Min) || !ObstructionBatch.Region.IsInsideOrOn(CapsuleBounds.Max))
+	{
+		INC_DWORD_STAT(STAT_Climbing_ObstructionQueries);
+		NumObstructionQueries++;
+		return IsCapsuleObstructedAt(Transform);
+	}
+
+	if (!ObstructionBatch.bIsGathered)
+	{
+		GatherObstructionBatch();
+	}
+
+	for (int32 i = 0; i < ObstructionBatch.Primitives.Num(); i++)
+	{
+		if (!ObstructionBatch.Bounds[i].Intersect(CapsuleBounds))
+		{
+			continue;
+		}
+
+		INC_DWORD_STAT(STAT_Climbing_BatchedObstructionTests);
+		if (ObstructionBatch.Primitives[i]->OverlapComponent(Transform.GetLocation(), Transform.GetRotation(), Capsule))
+		{
+#if WITH_CLIMBING_DEBUG
+			if (DebugSnapshot.IsValid())
+			{
+				DebugSnapshot->LastObstructedBy = ObstructionBatch.Primitives[i]->GetOwner();
+			}
+#endif
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void UClimbingComponent::GatherObstructionBatch()
+{
+	ObstructionBatch.bIsGathered = true;
+
+	INC_DWORD_STAT(STAT_Climbing_ObstructionQueries);
+	NumObstructionQueries++;
+
+	ObstructionOverlaps.Reset();
+	GetWorld()->OverlapMultiByObjectType(ObstructionOverlaps, ObstructionBatch.Region.GetCenter(), FQuat::Identity,
+		GetObstructionObjectParams(), FCollisionShape::MakeBox(ObstructionBatch.Region.GetExtent()));
+
+	// Whatever doesn't block Mokosh can be thrown out once here, instead of for every capsule
+	for (const auto& Overlap : ObstructionOverlaps)
+	{
+		if (!DoesOverlapBlockClimbing(Overlap))
+		{
+			continue;
+		}
+
+		auto Primitive = Overlap.Component.Get();
+		if (!ObstructionBatch.Primitives.Contains(Primitive))
 		{
-			if (bIsFlyingForwardInAir)
+			ObstructionBatch.Primitives.Add(Primitive);
+			ObstructionBatch.Bounds.Add(Primitive->Bounds.GetBox());
+		}
+	}
+}
+
+const FCollisionObjectQueryParams& UClimbingComponent::GetObstructionObjectParams()
+{
+	static const FCollisionObjectQueryParams ObjectParams = []
+	{
+		FCollisionObjectQueryParams Params;
+		Params.AddObjectTypesToQuery(ECollisionChannel::ECC_WorldStatic);
+		Params.AddObjectTypesToQuery(ECollisionChannel::ECC_WorldDynamic);
+
+		// Climbables used to be WorldStatic, and the ones that block Mokosh still need to stop her hanging inside them
+		Params.AddObjectTypesToQuery(ECC_Climbable);
+		return Params;
+	}();
+	return ObjectParams;
+}
+
+bool UClimbingComponent::DoesOverlapBlockClimbing(const FOverlapResult& Overlap)
+{
+	// Let's see if the actor if set to block Mokosh
+	return Overlap.Component.IsValid() &&
+		Overlap.Component->GetCollisionResponseToChannel(ECC_MokoshChannel) == ECollisionResponse::ECR_Block;
+}
+
+bool UClimbingComponent::CanComponentBlockClimbing(const UPrimitiveComponent* Primitive)
+{
+	return Primitive->IsRegistered() && Primitive->IsQueryCollisionEnabled() &&
+		(GetObstructionObjectParams().GetQueryBitfield() & ECC_TO_BITFIELD(Primitive->GetCollisionObjectType())) != 0 &&
+		Primitive->GetCollisionResponseToChannel(ECC_MokoshChannel) == ECollisionResponse::ECR_Block;
+}
+
+#if WITH_CLIMBING_DEBUG
+const FClimbingDebugSnapshot& UClimbingComponent::RequestDebugSnapshot()
+{
+	if (!DebugSnapshot.IsValid())
+	{
+		DebugSnapshot = MakeUnique<FClimbingDebugSnapshot>();
+	}
+
+	DebugSnapshot->LastRequestFrame = GFrameCounter;
+	return *DebugSnapshot;
+}
+#endif
+
+bool UClimbingComponent::IsAnyOverlapBlocking(const TArray<FOverlapResult>& Overlaps) const
+{
+	for (const auto& Result : Overlaps)
+	{
+		if (DoesOverlapBlockClimbing(Result))
+		{
+#if WITH_CLIMBING_DEBUG
+			if (DebugSnapshot.IsValid())
 			{
-				UKismetSystemLibrary::DrawDebugCapsule(World, FlyingForwardCastPosition, FlyingForwardCapsuleHeight * 0.5f, 
-					FlyingForwardCapsuleRadius, FRotator::ZeroRotator, FLinearColor::Green);
+				DebugSnapshot->LastObstructedBy = Result.GetActor();
 			}
-			else
+#endif
+			return true;
+		}
+	}
+
+	return false;
+}
+
+UClimbingComponent::EObstructionResult UClimbingComponent::GetObstruction(AClimbable* Climbable, bool bCanWaitForAsyncQueries)
+{
+	if (!bUseAsyncObstructionQueries)
+	{
+		return IsPlayerCapsuleInsideCollision(Climbable) ? EObstructionResult::Obstructed : EObstructionResult::Clear;
+	}
+
+	// The result is only any good if it was taken where we'd be hanging now, since the hanging position follows our capsule
+	auto Result = AsyncObstructionResults.Find(Climbable->GetUniqueID());
+	if (Result != nullptr && !Result->bIsPending && Result->Climbable.Get() == Climbable &&
+		GFrameCounter - Result->Frame <= static_cast<uint64>(AsyncObstructionResultLifetime))
+	{
+		const auto HangingTransform = GetHangingPosition(Climbable);
+		if (HangingTransform.GetLocation().Equals(Result->HangingLocation, 1.0f) &&
+			HangingTransform.GetRotation().Equals(Result->HangingRotation, KINDA_SMALL_NUMBER))
+		{
+			INC_DWORD_STAT(STAT_Climbing_AsyncObstructionHits);
+			return Result->bIsObstructed ? EObstructionResult::Obstructed : EObstructionResult::Clear;
+		}
+	}
+
+	INC_DWORD_STAT(STAT_Climbing_AsyncObstructionMisses);
+
+	if (bCanWaitForAsyncQueries)
+	{
+		AsyncObstructionPriority.AddUnique(Climbable);
+		return EObstructionResult::Pending;
+	}
+
+	// Button presses need an answer right now
+	return IsPlayerCapsuleInsideCollision(Climbable) ? EObstructionResult::Obstructed : EObstructionResult::Clear;
+}
+
+void UClimbingComponent::IssueAsyncObstructionQueries()
+{
+	CLIMBING_SCOPE_CYCLE_COUNTER(STAT_Climbing_IssueAsyncObstructionQueries);
+
+	// Don't hang on to results for climbables we've left behind
+	for (auto It = AsyncObstructionResults.CreateIterator(); It; ++It)
+	{
+		auto Climbable = It->Value.Climbable.Get();
+		if (Climbable == nullptr || !PossibleClimbables.Contains(Climbable))
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	int32 QueriesLeft = MaxAsyncObstructionQueriesPerFrame;
+
+	for (auto Climbable : AsyncObstructionPriority)
+	{
+		if (QueriesLeft > 0 && IssueAsyncObstructionQuery(Climbable))
+		{
+			QueriesLeft--;
+		}
+	}
+	AsyncObstructionPriority.Reset();
+
+	// Then keep cycling through the rest of what's around us, so there's usually a fresh result by the time it's needed
+	const auto NumCandidates = PossibleClimbables.Num();
+	for (int i = 0; i < NumCandidates && QueriesLeft > 0; i++)
+	{
+		AsyncObstructionCursor = (AsyncObstructionCursor + 1) % NumCandidates;
+		auto Climbable = PossibleClimbables[AsyncObstructionCursor];
+		if (Climbable == nullptr || !Climbable->bIsClimbable || Cast<ASplineLedge>(Climbable) != nullptr)
+		{
+			continue;
+		}
+
+		// These never need an obstruction check
+		if (AsyncObstructionCursor < NumBakedCandidates && !Climbable->bIsMoving)
+		{
+			continue;
+		}
+
+		// Anything still waiting on an answer or with a recent one can be skipped
+		auto Result = AsyncObstructionResults.Find(Climbable->GetUniqueID());
+		if (Result != nullptr && Result->Climbable.Get() == Climbable &&
+			GFrameCounter - Result->Frame < static_cast<uint64>(AsyncObstructionResultLifetime))
+		{
+			continue;
+		}
+
+		if (IssueAsyncObstructionQuery(Climbable))
+		{
+			QueriesLeft--;
+		}
+	}
+}
+
+bool UClimbingComponent::IssueAsyncObstructionQuery(AClimbable* Climbable)
+{
+	auto World = GetWorld();
+	if (World == nullptr || Climbable == nullptr)
+	{
+		return false;
+	}
+
+	// If a query never came back for some reason, we just send a new one once it's as old as a result would be
+	auto& Result = AsyncObstructionResults.FindOrAdd(Climbable->GetUniqueID());
+	if (Result.bIsPending && Result.Climbable.Get() == Climbable &&
+		GFrameCounter - Result.Frame < static_cast<uint64>(AsyncObstructionResultLifetime))
+	{
+		return false;
+	}
+
+	if (!AsyncObstructionDelegate.IsBound())
+	{
+		AsyncObstructionDelegate.BindUObject(this, &UClimbingComponent::OnAsyncObstructionOverlap);
+	}
+
+	const auto HangingTransform = GetHangingPosition(Climbable);
+	Result.Climbable = Climbable;
+	Result.HangingLocation = HangingTransform.GetLocation();
+	Result.HangingRotation = HangingTransform.GetRotation();
+	Result.Frame = GFrameCounter;
+	Result.bIsPending = true;
+	INC_DWORD_STAT(STAT_Climbing_AsyncObstructionQueries);
+
+	// The datum hands back the climbable's id along with the location and rotation, which is how we find the result again
+	World->AsyncOverlapByObjectType(Result.HangingLocation, Result.HangingRotation, GetObstructionObjectParams(),
+		FCollisionShape::MakeCapsule(CharacterCapsule->GetScaledCapsuleRadius(), CharacterCapsule->GetScaledCapsuleHalfHeight()),
+		FCollisionQueryParams::DefaultQueryParam, &AsyncObstructionDelegate, Climbable->GetUniqueID());
+
+	return true;
+}
+
+void UClimbingComponent::OnAsyncObstructionOverlap(const FTraceHandle& TraceHandle, FOverlapDatum& OverlapDatum)
+{
+	auto Result = AsyncObstructionResults.Find(OverlapDatum.UserData);
+	if (Result == nullptr || !Result->bIsPending || !Result->Climbable.IsValid())
+	{
+		return;
+	}
+
+	// If it was re-sent from somewhere else in the meantime, this answer is for the wrong spot
+	if (!Result->HangingLocation.Equals(OverlapDatum.Pos) || !Result->HangingRotation.Equals(OverlapDatum.Rot))
+	{
+		return;
+	}
+
+	Result->bIsObstructed = IsAnyOverlapBlocking(OverlapDatum.OutOverlaps);
+	Result->bIsPending = false;
+	Result->Frame = GFrameCounter;
+}
+
+void UClimbingComponent::TickComponent(float DeltaTime, ELevelTick TickType,
+                                       FActorComponentTickFunction* ThisTickFunction)
+{
+	CLIMBING_SCOPE_CYCLE_COUNTER(STAT_Climbing_Tick);
+	CLIMBING_PERF_SCOPE(Tick);
+
+#if WITH_CLIMBING_DEBUG
+	// The debugger has stopped showing us, so stop filling it in
+	if (bIsDebugging && !DebugSnapshot.IsValid())
+	{
+		DebugSnapshot = MakeUnique<FClimbingDebugSnapshot>();
+	}
+	else if (!bIsDebugging && DebugSnapshot.IsValid() && GFrameCounter - DebugSnapshot->LastRequestFrame > 2)
+	{
+		DebugSnapshot.Reset();
+	}
+#endif
+
+	// The subsystem picks us up again later in the frame, along with everyone else using the batched tick
+	if (bUseBatchedTick)
+	{
+		auto ClimbableSubsystem = GetWorld()->GetSubsystem<UClimbableSubsystem>();
+		if (ClimbableSubsystem != nullptr && ClimbableSubsystem->QueueClimbingTick(this, DeltaTime, TickType))
+		{
+			return;
+		}
+	}
+
+	if (BeginTick(DeltaTime, TickType))
+	{
+		ComputeTick(DeltaTime);
+		ApplyTick(DeltaTime, TickType);
+	}
+}
+
+bool UClimbingComponent::BeginTick(float DeltaTime, ELevelTick TickType)
+{
+	if (FinishTickEarly(DeltaTime, TickType))
+	{
+		// Whatever state stopped the tick short still needs a tick rate picked for it, or we'd keep the last one or stay asleep
+		if (bUseAdaptiveTick)
+		{
+			UpdateAdaptiveTick();
+		}
+		return false;
+	}
+
+	// This can update the player's state, so it can't wait for ComputeTick
+	CalculateCharacterState();
+
+	TickInputs = GetTickInputs();
+	return true;
+}
+
+bool UClimbingComponent::FinishTickEarly(float DeltaTime, ELevelTick TickType)
+{
+	// A replay drives detection itself
+	if (Replay.IsValid())
+	{
+		return true;
+	}
+
+	// If we're currently mantling we don't need to worry about any of this stuff
+	if (bIsCurrentlyMantling)
+	{
+		return true;
+	}
+
+	// Someone else decides where this character climbs, all that's left is playing back the jumps ClimbState tells us about
+	if (!IsClimbingDecidedHere())
+	{
+		Super::TickComponent(DeltaTime, TickType, &PrimaryComponentTick);
+		UpdateMovement(DeltaTime);
+		return true;
+	}
+
+	// We don't want auto grabber on while in a cinematic or while being thrown by the boss
+	if (PlayerRef->GetState() == EPlayerStates::Cinematic || PlayerRef->GetState() == EPlayerStates::BossThrown)
+	{
+		// Grabbing is still off, but the arc is gathered so it's ready the moment the throw lets go of us
+		auto ClimbableSubsystem = GetWorld()->GetSubsystem<UClimbableSubsystem>();
+		if (bUsePredictivePrefetch && PlayerRef->GetState() == EPlayerStates::BossThrown && ClimbableSubsystem != nullptr)
+		{
+			const TArray<AActor*, TInlineAllocator<2>> IgnoreList = {CurrentClimbable, NextClimbable};
+			UpdateTrajectoryPrefetch(ClimbableSubsystem, GetOwner()->GetActorLocation() + CapsuleOffset, IgnoreList);
+		}
+		return true;
+	}
+
+	return false;
+}
+
+void UClimbingComponent::ComputeTick(float DeltaTime)
+{
+	CLIMBING_SCOPE_CYCLE_COUNTER(STAT_Climbing_ComputeTick);
+
+	// This can be running on a worker thread next to other climbers, so it only writes TickCommands and our own detection state,
+	// and everything it asks the subsystem goes through the query context the subsystem gave this thread
+	auto LocalVelocity = UKismetMathLibrary::InverseTransformDirection(GetOwner()->GetTransform(), CharacterMovement->Velocity);
+	TickCommands.bIsFlyingForwardInAir = LocalVelocity.X > MinimumAutoGrabForwardVelocity &&
+		CharacterMovement->IsMovingOnGround() == false &&
+		IsClimbing() == false;
+
+	ComputeWallTimerStep(LocalVelocity, TickInputs, TickCommands.WallTimer);
+
+	GatherClimbables(TickCommands.bIsFlyingForwardInAir);
+
+	// Both the held forward check and the auto grab in ApplyTick want this, so it's rated here along with everyone else's
+	TickCommands.bHasForwardPick = TickCommands.WallTimer.bHoldingForwardDoCheck ||
+		(TickCommands.bIsFlyingForwardInAir && bHasPossibleTargets);
+	TickCommands.ForwardPick = nullptr;
+	if (TickCommands.bHasForwardPick)
+	{
+		CLIMBING_PERF_SCOPE(FindBestClimbable);
+		TickCommands.ForwardPick = SelectBestClimbable(FVector2D(0, 1), CDT_ForwardInAir, /*bCanWaitForAsyncQueries: */true);
+		TickCommands.ForwardPickJumpNumber = NumJumpsStarted;
+	}
+
+	TickCommands.bHasJumpStep = IsMovingToNewClimbable() && MovementCurve != nullptr;
+	if (TickCommands.bHasJumpStep)
+	{
+		ComputeJumpStep(DeltaTime, TickCommands.JumpStep);
+	}
+}
+
+void UClimbingComponent::ApplyTick(float DeltaTime, ELevelTick TickType)
+{
+	bIsFlyingForwardInAir = TickCommands.bIsFlyingForwardInAir;
+
+	ApplyWallTimerStep(TickCommands.WallTimer);
+
+	if (Recorder.IsValid())
+	{
+		auto ClimbableSubsystem = GetWorld()->GetSubsystem<UClimbableSubsystem>();
+		RecordedMovingClimbables.Reset();
+		if (ClimbableSubsystem != nullptr)
+		{
+			ClimbableSubsystem->GetMovingClimbables(RecordedMovingClimbables);
+		}
+		Recorder->RecordFrame(DeltaTime, RecordedMovingClimbables);
+	}
+
+	if (Recorder.IsValid())
+	{
+		Recorder->RecordDetect(GetRecordedState(), PossibleClimbables);
+	}
+
+	Super::TickComponent(DeltaTime, TickType, &PrimaryComponentTick);
+
+	if (bHoldingForwardDoCheck)
+	{
+		auto Climbable = FindBestForwardInAirClimbable();
+		AttemptClimb(Climbable);
+	}
+
+	AutoGrabChecker();
+
+	if (ClimbRouteStatus == EClimbRouteStatusEnum::CRS_Planning || ClimbRouteStatus == EClimbRouteStatusEnum::CRS_Succeeded)
+	{
+		UpdateClimbRoute();
+	}
+
+	// The step is thrown away if anything above started a new jump or let go
+	if (TickCommands.bHasJumpStep && TickCommands.JumpStep.JumpNumber == NumJumpsStarted && IsMovingToNewClimbable())
+	{
+		CLIMBING_SCOPE_CYCLE_COUNTER(STAT_Climbing_UpdateMovement);
+		CLIMBING_PERF_SCOPE(UpdateMovement);
+		ApplyJumpStep(TickCommands.JumpStep);
+	}
+	else
+	{
+		UpdateMovement(DeltaTime);
+	}
+
+	// These get picked up next tick, by then we'll know if the candidates around us are free
+	if (bUseAsyncObstructionQueries)
+	{
+		IssueAsyncObstructionQueries();
+	}
+
+	if (bUseAdaptiveTick)
+	{
+		UpdateAdaptiveTick();
+	}
+}
+
+void UClimbingComponent::UpdateAdaptiveTick()
+{
+	// Anything that needs a quick response gets the full tick rate, including a throw that could let go of us at any moment
+	const bool bIsBeingThrown = PlayerRef != nullptr && PlayerRef->GetState() == EPlayerStates::BossThrown;
+	if (IsClimbing() || bIsFlyingForwardInAir || bHasPossibleTargets || bIsHoldingDownForward || bIsCurrentlyMantling ||
+		bIsBeingThrown || ClimbRouteStatus == EClimbRouteStatusEnum::CRS_Planning)
+	{
+		SetComponentTickInterval(0.0f);
+		return;
+	}
+
+	auto World = GetWorld();
+	auto ClimbableSubsystem = World != nullptr ? World->GetSubsystem<UClimbableSubsystem>() : nullptr;
+	if (ClimbableSubsystem == nullptr)
+	{
+		return;
+	}
+
+	// Once we're away from every cluster there's nothing to do until we walk into one of their volumes again
+	if (!ClimbableSubsystem->IsInsideProximityVolume(GetOwner()->GetActorLocation()))
+	{
+		SetComponentTickEnabled(false);
+		return;
+	}
+
+	SetComponentTickInterval(IdleTickInterval);
+}
+
+void UClimbingComponent::WakeUp()
+{
+	SetComponentTickInterval(0.0f);
+	if (!IsComponentTickEnabled())
+	{
+		SetComponentTickEnabled(true);
+	}
+}
+
+bool UClimbingComponent::StartClimbingRecording(const FString& Filename)
+{
+	if (Replay.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Can't record climbing while a replay is playing"));
+		return false;
+	}
+
+	if (!Recorder.IsValid())
+	{
+		Recorder = MakeUnique<FClimbingRecorder>();
+	}
+
+	if (!Recorder->Start(Filename, GetWorld()))
+	{
+		Recorder.Reset();
+		return false;
+	}
+	return true;
+}
+
+void UClimbingComponent::StopClimbingRecording()
+{
+	Recorder.Reset();
+}
+
+bool UClimbingComponent::StartClimbingReplay(const FString& Filename)
+{
+	StopClimbingRecording();
+	StopClimbingReplay();
+
+	auto NewReplay = MakeUnique<FClimbingReplay>();
+	if (!NewReplay->Recording.Load(Filename))
+	{
+		return false;
+	}
+
+	NewReplay->Recording.ResolveClimbables(GetWorld(), NewReplay->Climbables);
+	for (int32 i = 0; i < NewReplay->Climbables.Num(); i++)
+	{
+		if (NewReplay->Climbables[i] != nullptr)
+		{
+			NewReplay->ClimbableIndices.Add(NewReplay->Climbables[i], i);
+		}
+	}
+
+	// Waiting on async results would make what gets picked depend on timing, so everything is checked on the spot
+	NewReplay->bWasUsingAsyncObstructionQueries = bUseAsyncObstructionQueries;
+	bUseAsyncObstructionQueries = false;
+
+	// Nothing should move the character around between recorded ticks
+	NewReplay->bWasMovementTickEnabled = CharacterMovement->IsComponentTickEnabled();
+	CharacterMovement->SetComponentTickEnabled(false);
+
+	DetectionCache.bIsValid = false;
+	MovingClimbableFollow.Climbable.Reset();
+
+	NewReplay->TickerHandle = FTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateUObject(this, &UClimbingComponent::TickClimbingReplay));
+
+	UE_LOG(LogTemp, Log, TEXT("Replaying %d climbing frames from %s"), NewReplay->Recording.Frames.Num(), *Filename);
+	Replay = MoveTemp(NewReplay);
+	return true;
+}
+
+void UClimbingComponent::StopClimbingReplay()
+{
+	if (!Replay.IsValid())
+	{
+		return;
+	}
+
+	if (Replay->TickerHandle.IsValid())
+	{
+		FTicker::GetCoreTicker().RemoveTicker(Replay->TickerHandle);
+	}
+
+	ReportClimbingReplay();
+
+	bUseAsyncObstructionQueries = Replay->bWasUsingAsyncObstructionQueries;
+	CharacterMovement->SetComponentTickEnabled(Replay->bWasMovementTickEnabled);
+	DetectionCache.bIsValid = false;
+	Replay.Reset();
+
+	// Whatever the last recorded tick was hanging off, we're not really attached to it
+	if (IsClimbing())
+	{
+		DetachFromClimbing();
+	}
+
+	if (bUseAdaptiveTick)
+	{
+		WakeUp();
+	}
+}
+
+int32 UClimbingComponent::FClimbingReplay::GetClimbableIndex(const AClimbable* Climbable) const
+{
+	if (Climbable == nullptr)
+	{
+		return INDEX_NONE;
+	}
+
+	// Climbables that weren't in the recording at all still need to count as different from everything that was
+	auto Index = ClimbableIndices.Find(Climbable);
+	return Index != nullptr ? *Index : TNumericLimits<int32>::Max();
+}
+
+bool UClimbingComponent::TickClimbingReplay(float DeltaTime)
+{
+	const auto FrameIndex = Replay->NextFrame++;
+	const auto& Frame = Replay->Recording.Frames[FrameIndex];
+
+	auto ClimbableSubsystem = GetWorld()->GetSubsystem<UClimbableSubsystem>();
+	for (const auto& Mover : Frame.MovingClimbables)
+	{
+		auto Climbable = Replay->GetClimbable(Mover.Climbable);
+		if (Climbable == nullptr)
+		{
+			continue;
+		}
+
+		Climbable->SetActorLocationAndRotation(Mover.Location, Mover.Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+		if (ClimbableSubsystem != nullptr)
+		{
+			ClimbableSubsystem->UpdateClimbable(Climbable);
+		}
+	}
+
+	// Only the calls being replayed are timed, not putting the character back where it was
+	uint64 Cycles = 0;
+	TArray<int32, TInlineAllocator<64>> Detected;
+	for (const auto& Event : Frame.Events)
+	{
+		ApplyRecordedState(Event.State);
+
+		if (Event.bIsQuery)
+		{
+			const auto StartCycles = FPlatformTime::Cycles64();
+			auto Climbable = SelectBestClimbable(Event.InputDirection, static_cast<EClimableDetectionTypeEnum>(Event.DetectionType),
+				/*bCanWaitForAsyncQueries: */false);
+			Cycles += FPlatformTime::Cycles64() - StartCycles;
+
+			// Nothing could mean it was still waiting on an async result when it was recorded, so that's not held against us
+			const uint8 PendingFlags = FClimbingRecordedEvent::CRF_CanWaitForAsyncQueries | FClimbingRecordedEvent::CRF_UsedAsyncObstructionQueries;
+			const bool bMightHaveBeenPending = Event.Result == INDEX_NONE && (Event.Flags & PendingFlags) == PendingFlags;
+
+			Replay->NumQueries++;
+			if (Replay->GetClimbableIndex(Climbable) != Event.Result && !bMightHaveBeenPending)
 			{
-				UKismetSystemLibrary::DrawDebugSphere(World, CastTarget, DetectionRadius, 12, FLinearColor::Green);
+				Replay->NumQueryMismatches++;
+				UE_LOG(LogTemp, Warning, TEXT("Climbing replay frame %d: picked %s, the recording picked %s"), FrameIndex,
+					*GetNameSafe(Climbable), *GetNameSafe(Replay->GetClimbable(Event.Result)));
 			}
+			continue;
+		}
+
+		const auto StartCycles = FPlatformTime::Cycles64();
+		DetectClimbables();
+		Cycles += FPlatformTime::Cycles64() - StartCycles;
+
+		// The order they come out in depends on how they were found, so only what was found is compared
+		Detected.Reset();
+		for (auto Climbable : PossibleClimbables)
+		{
+			Detected.Add(Replay->GetClimbableIndex(Climbable));
 		}
+		Detected.Sort();
+
+		auto Recorded = Event.Climbables;
+		Recorded.Sort();
+
+		Replay->NumDetections++;
+		if (Detected.Num() != Recorded.Num() || FMemory::Memcmp(Detected.GetData(), Recorded.GetData(), Detected.Num() * sizeof(int32)) != 0)
+		{
+			Replay->NumDetectionMismatches++;
+			UE_LOG(LogTemp, Warning, TEXT("Climbing replay frame %d: detected %d climbables, the recording detected %d, or different ones"),
+				FrameIndex, Detected.Num(), Recorded.Num());
+		}
+	}
+
+	Replay->FrameTimes.Add(FPlatformTime::ToMilliseconds64(Cycles));
+
+	if (Replay->NextFrame < Replay->Recording.Frames.Num())
+	{
+		return true;
+	}
+
+	// Returning false takes the ticker out, so there's nothing left for StopClimbingReplay to remove
+	Replay->TickerHandle.Reset();
+	StopClimbingReplay();
+	return false;
+}
+
+void UClimbingComponent::ReportClimbingReplay() const
+{
+	auto FrameTimes = Replay->FrameTimes;
+	if (FrameTimes.Num() == 0)
+	{
+		return;
+	}
+	FrameTimes.Sort();
+
+	double Total = 0.0;
+	for (auto FrameTime : FrameTimes)
+	{
+		Total += FrameTime;
+	}
+
+	const auto GetPercentile = [&FrameTimes](float Percentile)
+	{
+		return FrameTimes[FMath::Min(FMath::FloorToInt(FrameTimes.Num() * Percentile), FrameTimes.Num() - 1)];
+	};
+
+	UE_LOG(LogTemp, Log, TEXT("Climbing replay: %d of %d frames, %.3fms mean, %.3fms median, %.3fms 95th, %.3fms 99th, %.3fms worst"),
+		FrameTimes.Num(), Replay->Recording.Frames.Num(), Total / FrameTimes.Num(), GetPercentile(0.5f), GetPercentile(0.95f),
+		GetPercentile(0.99f), FrameTimes.Last());
+	UE_LOG(LogTemp, Log, TEXT("Climbing replay: %d of %d detections and %d of %d picks differed from the recording"),
+		Replay->NumDetectionMismatches, Replay->NumDetections, Replay->NumQueryMismatches, Replay->NumQueries);
+}
+
+bool UClimbingComponent::IsMovingOnGround() const
+{
+	return Replay.IsValid() ? Replay->bIsMovingOnGround : CharacterMovement->IsMovingOnGround();
+}
+
+FClimbingRecordedState UClimbingComponent::GetRecordedState()
+{
+	FClimbingRecordedState State;
+	State.Location = GetOwner()->GetActorLocation();
+	State.Rotation = GetOwner()->GetActorRotation();
+	State.Velocity = CharacterMovement->Velocity;
+	State.VerticalAxis = GetOwner()->GetInputAxisValue("Vertical");
+	State.HorizontalAxis = GetOwner()->GetInputAxisValue("Horizontal");
+	State.CharacterState = static_cast<uint8>(CharacterState);
+	State.bIsMovingOnGround = CharacterMovement->IsMovingOnGround();
+	State.bIsFlyingForwardInAir = bIsFlyingForwardInAir;
+	State.CurrentClimbable = Recorder->GetClimbableIndex(CurrentClimbable);
+	State.NextClimbable = Recorder->GetClimbableIndex(NextClimbable);
+	return State;
+}
+
+void UClimbingComponent::ApplyRecordedState(const FClimbingRecordedState& State)
+{
+	GetOwner()->SetActorLocationAndRotation(State.Location, State.Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+	CharacterMovement->Velocity = State.Velocity;
+	CharacterState = static_cast<ECharacterStateEnum>(State.CharacterState);
+	bIsFlyingForwardInAir = State.bIsFlyingForwardInAir;
+	Replay->bIsMovingOnGround = State.bIsMovingOnGround;
+	CurrentClimbable = Replay->GetClimbable(State.CurrentClimbable);
+	NextClimbable = Replay->GetClimbable(State.NextClimbable);
+}
+
+void UClimbingComponent::RequestClimbRoute(AClimbable* Target)
+{
+	if (Target == nullptr)
+	{
+		CancelClimbRoute();
+		return;
 	}
-	else
+
+	RouteGoalClimbable = Target;
+	bHasRouteGoalClimbable = true;
+	RouteGoalLocation = Target->GetActorLocation();
+	RouteGoalRadius = 0.0f;
+	StartClimbRoutePlanning();
+}
+
+void UClimbingComponent::RequestClimbRouteToLocation(FVector Location, float AcceptanceRadius)
+{
+	RouteGoalClimbable = nullptr;
+	bHasRouteGoalClimbable = false;
+	RouteGoalLocation = Location;
+	RouteGoalRadius = AcceptanceRadius;
+	StartClimbRoutePlanning();
+}
+
+void UClimbingComponent::CancelClimbRoute()
+{
+	RoutePlanner.Reset();
+	ClimbRoute.Reset();
+	ClimbRouteStatus = EClimbRouteStatusEnum::CRS_None;
+}
+
+bool UClimbingComponent::ClimbAlongRoute()
+{
+	if (ClimbRouteStatus != EClimbRouteStatusEnum::CRS_Succeeded || IsMovingToNewClimbable() || bIsCurrentlyMantling)
 	{
-		bHasPossibleTargets = false;
-		PossibleClimbables.Empty();
+		return false;
+	}
 
-		if (bIsDebugging)
-		{
-			if (bIsFlyingForwardInAir)
-			{
-				UKismetSystemLibrary::DrawDebugCapsule(World, FlyingForwardCastPosition, FlyingForwardCapsuleHeight * 0.5f,
-					FlyingForwardCapsuleRadius, FRotator::ZeroRotator, FLinearColor::Red);
-			}
-			else
-			{
-				UKismetSystemLibrary::DrawDebugSphere(World, CastTarget, DetectionRadius, 12, FLinearColor::Red);
-			}
-		}
+	// Everything up to the climbable we're on has already been climbed
+	const auto Reached = ClimbRoute.Find(CurrentClimbable);
+	if (Reached != INDEX_NONE)
+	{
+		ClimbRoute.RemoveAt(0, Reached + 1, /*bAllowShrinking: */false);
+	}
+
+	if (ClimbRoute.Num() == 0)
+	{
+		return false;
 	}
+
+	return AttemptClimb(ClimbRoute[0]);
 }
 
-bool UClimbingComponent::IsPlayerCapsuleInsideCollision(AActor* Climbable)
+void UClimbingComponent::StartClimbRoutePlanning()
 {
 	auto World = GetWorld();
-	if (World == nullptr)
+	auto ClimbableSubsystem = World != nullptr ? World->GetSubsystem<UClimbableSubsystem>() : nullptr;
+
+	// In the middle of a jump, the route starts from wherever we're landing
+	auto StartClimbable = NextClimbable != nullptr ? NextClimbable : CurrentClimbable;
+	RoutePlanner.Start(StartClimbable, GetOwner()->GetActorLocation(), RouteGoalClimbable.Get(), RouteGoalLocation, RouteGoalRadius,
+		MaxRouteSearchNodes);
+	RoutePlanningGeneration = ClimbableSubsystem != nullptr ? ClimbableSubsystem->GetGeneration() : 0;
+	ClimbRoute.Reset();
+	ClimbRouteStatus = EClimbRouteStatusEnum::CRS_Planning;
+
+	if (bUseAdaptiveTick)
 	{
-		return false;
+		WakeUp();
 	}
+}
 
-	TArray<FOverlapResult> Overlaps;
-	TArray<TEnumAsByte<EObjectTypeQuery>> Params;
-	Params.Add(UEngineTypes::ConvertToObjectType(ECollisionChannel::ECC_WorldStatic));
-	Params.Add(UEngineTypes::ConvertToObjectType(ECollisionChannel::ECC_WorldDynamic));
-	
-	FCollisionObjectQueryParams ObjectParams = {Params};
-	auto Transform = GetHangingPosition(Climbable);
-	World->OverlapMultiByObjectType(Overlaps, Transform.GetLocation(), Transform.GetRotation(), ObjectParams,
-		FCollisionShape::MakeCapsule(CharacterCapsule->GetScaledCapsuleRadius(), CharacterCapsule->GetScaledCapsuleHalfHeight()));
+void UClimbingComponent::UpdateClimbRoute()
+{
+	CLIMBING_SCOPE_CYCLE_COUNTER(STAT_Climbing_RoutePlanning);
+	CLIMBING_PERF_SCOPE(UpdateClimbRoute);
+
+	auto World = GetWorld();
+	auto ClimbableSubsystem = World != nullptr ? World->GetSubsystem<UClimbableSubsystem>() : nullptr;
+	if (ClimbableSubsystem == nullptr)
+	{
+		return;
+	}
+
+	if (bHasRouteGoalClimbable && !RouteGoalClimbable.IsValid())
+	{
+		CancelClimbRoute();
+		ClimbRouteStatus = EClimbRouteStatusEnum::CRS_Failed;
+		OnClimbRouteFinished.Broadcast(false);
+		return;
+	}
+
+	if (ClimbRouteStatus == EClimbRouteStatusEnum::CRS_Succeeded)
+	{
+		// A moving climbable can carry a jump on the route out of reach, in which case we find a new way from where we are
+		if (!IsClimbRouteStillValid())
+		{
+			StartClimbRoutePlanning();
+		}
+		return;
+	}
+
+	// Climbables were added or removed while we were searching, so what we've found so far can't be trusted
+	if (ClimbableSubsystem->GetGeneration() != RoutePlanningGeneration)
+	{
+		StartClimbRoutePlanning();
+	}
+
+	const auto Budget = ClimbableSubsystem->ClaimRoutePlanningBudget(MaxRouteExpansionsPerTick);
+	const auto NumExpanded = RoutePlanner.Step(Budget,
+		[this, ClimbableSubsystem](AClimbable* From, const FVector& FromLocation, TArray<AClimbable*>& OutNeighbours)
+		{
+			GatherRouteNeighbours(ClimbableSubsystem, From, FromLocation, OutNeighbours);
+		});
+	INC_DWORD_STAT_BY(STAT_Climbing_RouteNodesExpanded, NumExpanded);
+
+	if (RoutePlanner.GetStatus() == EClimbRouteStatusEnum::CRS_Succeeded)
+	{
+		RoutePlanner.GetRoute(ClimbRoute);
+		ClimbRouteStatus = EClimbRouteStatusEnum::CRS_Succeeded;
+		OnClimbRouteFinished.Broadcast(true);
+	}
+	else if (RoutePlanner.GetStatus() == EClimbRouteStatusEnum::CRS_Failed)
+	{
+		ClimbRouteStatus = EClimbRouteStatusEnum::CRS_Failed;
+		OnClimbRouteFinished.Broadcast(false);
+	}
+}
 
-	for (auto Result : Overlaps)
+bool UClimbingComponent::IsClimbRouteStillValid() const
+{
+	const AClimbable* Previous = NextClimbable != nullptr ? NextClimbable : CurrentClimbable;
+	const auto RadiusSquared = FMath::Square(ClimbingDetectionRadius);
+
+	for (auto Climbable : ClimbRoute)
 	{
-		// Let's see if the actor if set to block Mokosh
-		if (Result.Component->GetCollisionResponseToChannel(ECC_MokoshChannel) == ECollisionResponse::ECR_Block)
+		if (Climbable == nullptr || Climbable->IsPendingKill() || !Climbable->bIsClimbable)
+		{
+			return false;
+		}
+
+		// Jumps between two static climbables can't change, so only the ones involving something moving need checking
+		if (Previous != nullptr && (Previous->bIsMoving || Climbable->bIsMoving))
 		{
-			if (bIsDebugging)
+			FVector Origin, Extent;
+			Climbable->GetActorBounds(/*bOnlyCollidingComponents: */true, Origin, Extent);
+			if (FBox::BuildAABB(Origin, Extent).ComputeSquaredDistanceToPoint(Previous->GetActorLocation()) > RadiusSquared)
 			{
-				LOG(FString::Printf(TEXT("%s is in the way."), *Result.Actor->GetName()), 20);
+				return false;
 			}
-			
-			return true;
 		}
+
+		Previous = Climbable;
 	}
 
-	return false;
+	return true;
 }
 
-void UClimbingComponent::TickComponent(float DeltaTime, ELevelTick TickType,
-                                       FActorComponentTickFunction* ThisTickFunction)
+void UClimbingComponent::GatherRouteNeighbours(UClimbableSubsystem* ClimbableSubsystem, AClimbable* From, const FVector& FromLocation,
+                                               TArray<AClimbable*>& OutNeighbours)
 {
-	// If we're currently mantling we don't need to worry about any of this stuff
-	if (bIsCurrentlyMantling)
+	// From the ground we can get onto anything close enough that isn't below our feet
+	if (From == nullptr)
 	{
+		ClimbableSubsystem->QuerySphere(FromLocation, GroundClimbingDetectionRadius, TArrayView<AActor* const>(), OutNeighbours);
+
+		const auto MinimumZ = FromLocation.Z - CharacterCapsule->GetScaledCapsuleHalfHeight();
+		OutNeighbours.RemoveAllSwap([MinimumZ](const AClimbable* Climbable)
+		{
+			return !Climbable->bIsClimbable || Climbable->GetActorLocation().Z < MinimumZ;
+		}, /*bAllowShrinking: */false);
 		return;
 	}
 
-	// We don't want auto grabber on while in a cinematic or while being thrown by the boss
-	if (PlayerRef->GetState() == EPlayerStates::Cinematic || PlayerRef->GetState() == EPlayerStates::BossThrown)
+	// Getting to a ledge means mantling up it, which is where the climbing ends
+	if (Cast<ASplineLedge>(From) != nullptr)
 	{
 		return;
 	}
-	
-	auto LocalVelocity = UKismetMathLibrary::InverseTransformDirection(GetOwner()->GetTransform(), CharacterMovement->Velocity);
-	if (LocalVelocity.X > MinimumAutoGrabForwardVelocity &&
-		CharacterMovement->IsMovingOnGround() == false &&
-		IsClimbing() == false)
+
+	const auto FromClimbableLocation = From->GetActorLocation();
+	RouteCandidates.Reset();
+	if (!From->bIsMoving && bUseBakedClimbingGraph &&
+		ClimbableSubsystem->GetBakedNeighbours(From, ClimbingDetectionRadius, TArrayView<AActor* const>(), OutNeighbours))
 	{
-		bIsFlyingForwardInAir = true;
+		// Only the moving climbables and anything across a level seam still need to go through the filters
+		ClimbableSubsystem->AppendUnbakedInSphere(From, FromClimbableLocation, ClimbingDetectionRadius, TArrayView<AActor* const>(),
+			RouteCandidates);
 	}
 	else
 	{
-		bIsFlyingForwardInAir = false;
+		ClimbableSubsystem->QuerySphere(FromClimbableLocation, ClimbingDetectionRadius, TArrayView<AActor* const>(), RouteCandidates);
 	}
 
-	RunAgainstWallChecker();
-	
-	DetectClimbables();
-
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-
-	if (bHoldingForwardDoCheck)
+	ClimbingScoring::FilterReachable(From, GetClimbReachabilitySettings(), RouteCandidates, RouteScoringBatch, RouteReachable);
+	for (auto Candidate : RouteReachable)
 	{
-		auto Direction = FVector2D(0, 1);
-		auto Climbable = FindBestClimbable(Direction, CDT_ForwardInAir);
-		AttemptClimb(Climbable);
+		OutNeighbours.Add(RouteCandidates[Candidate]);
 	}
 
-	AutoGrabChecker();
-	UpdateMovement(DeltaTime);
+	OutNeighbours.RemoveAllSwap([](const AClimbable* Climbable)
+	{
+		return !Climbable->bIsClimbable;
+	}, /*bAllowShrinking: */false);
+}
 
+FClimbReachabilitySettings UClimbingComponent::GetClimbReachabilitySettings() const
+{
+	FClimbReachabilitySettings Settings;
+	Settings.CapsuleHalfHeight = CharacterCapsule->GetScaledCapsuleHalfHeight();
+	Settings.DistanceFromClimbTarget = DistanceFromClimbTarget;
+	Settings.MaxRotationDelta = MaxYRotation;
+	return Settings;
 }
 
 void UClimbingComponent::UpdateMovement(float DeltaTime)
 {
+	CLIMBING_SCOPE_CYCLE_COUNTER(STAT_Climbing_UpdateMovement);
+	CLIMBING_PERF_SCOPE(UpdateMovement);
+
 	if (!IsClimbing())
 	{
 		return;
@@ -639,24 +2086,9 @@ void UClimbingComponent::UpdateMovement(float DeltaTime)
 	{
 		if (MovementCurve != nullptr)
 		{
-			MovingTime += DeltaTime;
-			float MinTime, MaxTime;
-			MovementCurve->GetTimeRange(MinTime, MaxTime);
-			auto Val = MovementCurve->GetFloatValue(MovingTime);
-
-			// If we're done moving
-			if (MovingTime >= MaxTime)
-			{
-				HasMovedToNewClimbable();
-			}
-			else
-			{
-				auto HangingTransform = GetHangingPosition(NextClimbable);
-				GetOwner()->SetActorLocation(
-					UKismetMathLibrary::VLerp(BeforeMovingPosition, HangingTransform.GetLocation(), Val));
-				GetOwner()->SetActorRotation(
-					UKismetMathLibrary::RLerp(BeforeMovingRotation, HangingTransform.Rotator(), Val, /*bShortestPath: */true));
-			}
+			FJumpStep Step;
+			ComputeJumpStep(DeltaTime, Step);
+			ApplyJumpStep(Step);
 		}
 		else
 		{
@@ -671,48 +2103,174 @@ void UClimbingComponent::UpdateMovement(float DeltaTime)
 	}
 	else if (IsOnMovingClimbable())
 	{
+		if (bFollowMovingClimbableRelative)
+		{
+			FollowMovingClimbable();
+			return;
+		}
+
 		auto HangingTransform = GetHangingPosition(CurrentClimbable);
-		GetOwner()->SetActorRotation(HangingTransform.GetRotation());
-		GetOwner()->SetActorLocation(HangingTransform.GetLocation());
-		// To improve this further collision checks should be done here to make sure we're not going inside something while moving.
+		GetOwner()->SetActorLocationAndRotation(HangingTransform.GetLocation(), HangingTransform.GetRotation());
+		return;
+	}
+}
+
+void UClimbingComponent::ComputeJumpStep(float DeltaTime, FJumpStep& OutStep) const
+{
+	OutStep.JumpNumber = NumJumpsStarted;
+	OutStep.MovingTime = MovingTime + DeltaTime;
+
+	float MaxTime;
+	if (Jump.Curve.IsValid())
+	{
+		MaxTime = Jump.Curve->MaxTime;
+		OutStep.Alpha = Jump.Curve->Evaluate(OutStep.MovingTime);
+	}
+	else
+	{
+		float MinTime;
+		MovementCurve->GetTimeRange(MinTime, MaxTime);
+		OutStep.Alpha = MovementCurve->GetFloatValue(OutStep.MovingTime);
+	}
+
+	OutStep.bIsFinished = OutStep.MovingTime >= MaxTime;
+
+	// Looking up a moving end goes through the subsystem's ledge memos, which can't be done from here
+	OutStep.bHasTransform = !OutStep.bIsFinished && Jump.bHasFixedEnd;
+	if (OutStep.bHasTransform)
+	{
+		OutStep.Location = UKismetMathLibrary::VLerp(BeforeMovingPosition, Jump.EndLocation, OutStep.Alpha);
+		OutStep.Rotation = UKismetMathLibrary::RLerp(BeforeMovingRotation, Jump.EndRotation, OutStep.Alpha, /*bShortestPath: */true);
+	}
+}
+
+void UClimbingComponent::ApplyJumpStep(const FJumpStep& Step)
+{
+	MovingTime = Step.MovingTime;
+
+	// If we're done moving
+	if (Step.bIsFinished)
+	{
+		HasMovedToNewClimbable();
+		return;
+	}
+
+	if (Step.bHasTransform)
+	{
+		GetOwner()->SetActorLocationAndRotation(Step.Location, Step.Rotation);
 		return;
 	}
+
+	const auto HangingTransform = GetHangingPosition(NextClimbable);
+	GetOwner()->SetActorLocationAndRotation(
+		UKismetMathLibrary::VLerp(BeforeMovingPosition, HangingTransform.GetLocation(), Step.Alpha),
+		UKismetMathLibrary::RLerp(BeforeMovingRotation, HangingTransform.Rotator(), Step.Alpha, /*bShortestPath: */true));
+}
+
+void UClimbingComponent::FollowMovingClimbable()
+{
+	if (MovingClimbableFollow.Climbable.Get() != CurrentClimbable)
+	{
+		StartFollowingMovingClimbable();
+	}
+
+	const auto& ClimbableTransform = CurrentClimbable->GetActorTransform();
+	auto HangingTransform = MovingClimbableFollow.RelativeHangingTransform * ClimbableTransform;
+
+	// GetHangingPosition never rolls the capsule, so don't let a rolling climbable do it either
+	auto HangingRotation = HangingTransform.Rotator();
+	HangingRotation.Roll = 0.0f;
+	HangingTransform.SetRotation(HangingRotation.Quaternion());
+
+	// The overlap check only happens once the climbable has moved far enough for something to have gotten in the way. Only the machine
+	// that decides where we climb gets to let go, everyone else keeps following until ClimbState tells them we've detached.
+	const auto& ValidatedTransform = MovingClimbableFollow.ValidatedClimbableTransform;
+	const auto MovedSquared = FVector::DistSquared(ClimbableTransform.GetLocation(), ValidatedTransform.GetLocation());
+	const auto TurnedDegrees = FMath::RadiansToDegrees(ClimbableTransform.GetRotation().AngularDistance(ValidatedTransform.GetRotation()));
+	if (IsClimbingDecidedHere() &&
+		(MovedSquared > FMath::Square(MovingClimbableRevalidateDistance) || TurnedDegrees > MovingClimbableRevalidateAngle))
+	{
+		INC_DWORD_STAT(STAT_Climbing_MovingClimbableValidations);
+		MovingClimbableFollow.ValidatedClimbableTransform = ClimbableTransform;
+
+		if (IsCapsuleObstructedAt(HangingTransform))
+		{
+			DetachFromClimbing();
+			return;
+		}
+	}
+
+	GetOwner()->SetActorLocationAndRotation(HangingTransform.GetLocation(), HangingTransform.GetRotation());
+}
+
+void UClimbingComponent::StartFollowingMovingClimbable()
+{
+	const auto& ClimbableTransform = CurrentClimbable->GetActorTransform();
+
+	MovingClimbableFollow.Climbable = CurrentClimbable;
+	MovingClimbableFollow.RelativeHangingTransform = GetHangingPosition(CurrentClimbable).GetRelativeTransform(ClimbableTransform);
+	MovingClimbableFollow.ValidatedClimbableTransform = ClimbableTransform;
 }
 
 void UClimbingComponent::RunAgainstWallChecker()
 {
-	auto World = GetWorld();
-	if (World == nullptr)
+	CLIMBING_SCOPE_CYCLE_COUNTER(STAT_Climbing_RunAgainstWallChecker);
+
+	if (GetWorld() == nullptr)
 	{
 		return;
 	}
 
-	bool bTimerActive = World->GetTimerManager().IsTimerActive(TimerHandle_AutoGrabWall);
-	auto Vertical = GetOwner()->GetInputAxisValue("Horizontal");
-	auto LocalVelocity = UKismetMathLibrary::InverseTransformDirection(GetOwner()->GetTransform(), CharacterMovement->Velocity);
+	FWallTimerStep Step;
+	ComputeWallTimerStep(UKismetMathLibrary::InverseTransformDirection(GetOwner()->GetTransform(), CharacterMovement->Velocity),
+		GetTickInputs(), Step);
+	ApplyWallTimerStep(Step);
+}
+
+UClimbingComponent::FClimbingTickInputs UClimbingComponent::GetTickInputs() const
+{
+	auto World = GetWorld();
+
+	FClimbingTickInputs Inputs;
+	Inputs.bIsAutoGrabTimerActive = World != nullptr && World->GetTimerManager().IsTimerActive(TimerHandle_AutoGrabWall);
+	Inputs.ForwardInput = GetOwner()->GetInputAxisValue("Horizontal");
+	return Inputs;
+}
+
+void UClimbingComponent::ComputeWallTimerStep(const FVector& LocalVelocity, const FClimbingTickInputs& Inputs,
+                                              FWallTimerStep& OutStep) const
+{
+	using ETimerAction = FWallTimerStep::ETimerAction;
+
+	const bool bTimerActive = Inputs.bIsAutoGrabTimerActive;
+	const auto Vertical = Inputs.ForwardInput;
+
+	OutStep.TimerAction = ETimerAction::Keep;
+	OutStep.bIsHoldingDownForward = bIsHoldingDownForward;
+	OutStep.bHoldingForwardDoCheck = bHoldingForwardDoCheck;
 
 	if (IsClimbing())
 	{
-		bIsHoldingDownForward = false;
-		bHoldingForwardDoCheck = false;
+		OutStep.bIsHoldingDownForward = false;
+		OutStep.bHoldingForwardDoCheck = false;
 		if (bTimerActive)
 		{
-			World->GetTimerManager().ClearTimer(TimerHandle_AutoGrabWall);
+			OutStep.TimerAction = ETimerAction::Clear;
 		}
 	}
 	
 	// If we're not going forward
 	if (Vertical < 0.7f)
 	{
-		if (bIsHoldingDownForward)
+		if (OutStep.bIsHoldingDownForward)
 		{
 			if (bTimerActive)
 			{
-				World->GetTimerManager().ClearTimer(TimerHandle_AutoGrabWall);
-				bHoldingForwardDoCheck = false;
+				OutStep.TimerAction = ETimerAction::Clear;
+				OutStep.bHoldingForwardDoCheck = false;
 			}
 		}
-		bIsHoldingDownForward = false;
+		OutStep.bIsHoldingDownForward = false;
 	}
 	// If we're moving forward
 	else
@@ -720,25 +2278,47 @@ void UClimbingComponent::RunAgainstWallChecker()
 		// If we're moving forward but not actually moving
 		if (LocalVelocity.X < 100)
 		{
-			FTimerDelegate TimerCallback;
-			TimerCallback.BindLambda([&]
-			{
-				bHoldingForwardDoCheck = true;
-			});
-			
+			// Only bind the callback when the timer is actually started, this runs every frame we're up against a wall
 			if (!bTimerActive)
 			{
-				World->GetTimerManager().SetTimer(TimerHandle_AutoGrabWall, TimerCallback, TimeRunningAgainstWallToTryGrab, false);
+				OutStep.TimerAction = ETimerAction::Start;
 			}
 		}
 		else
 		{
-			World->GetTimerManager().ClearTimer(TimerHandle_AutoGrabWall);
-			bHoldingForwardDoCheck = false;
+			OutStep.TimerAction = ETimerAction::Clear;
+			OutStep.bHoldingForwardDoCheck = false;
 		}
 	}
 }
 
+void UClimbingComponent::ApplyWallTimerStep(const FWallTimerStep& Step)
+{
+	auto World = GetWorld();
+	if (World == nullptr)
+	{
+		return;
+	}
+
+	bIsHoldingDownForward = Step.bIsHoldingDownForward;
+	bHoldingForwardDoCheck = Step.bHoldingForwardDoCheck;
+
+	if (Step.TimerAction == FWallTimerStep::ETimerAction::Clear)
+	{
+		World->GetTimerManager().ClearTimer(TimerHandle_AutoGrabWall);
+	}
+	else if (Step.TimerAction == FWallTimerStep::ETimerAction::Start)
+	{
+		FTimerDelegate TimerCallback;
+		TimerCallback.BindLambda([&]
+		{
+			bHoldingForwardDoCheck = true;
+		});
+
+		World->GetTimerManager().SetTimer(TimerHandle_AutoGrabWall, TimerCallback, TimeRunningAgainstWallToTryGrab, false);
+	}
+}
+
 /* This is called when you finishing lerping to the ledge hang position*/
 void UClimbingComponent::OnHangingOnLedge()
 {
@@ -772,7 +2352,7 @@ void UClimbingComponent::OnHangingOnLedge()
 		NextClimbable = nullptr;
 		MovingTime = 0.0f;
 		
-		auto ClimbUpTransform = Ledge->GetClimbUpTransform(GetOwner());	
+		auto ClimbUpTransform = GetLedgeClimbUpTransform(Ledge);
 		GetOwner()->SetActorLocationAndRotation(ClimbUpTransform.GetLocation() + FVector::UpVector * 100.0f,
 		                                        (ClimbUpTransform.Rotator().Vector() * -1.0f).Rotation().Quaternion());
 		DetachFromClimbing();
@@ -790,6 +2370,11 @@ void UClimbingComponent::ClimbingMontageFinished(class UAnimMontage* Montage, bo
 	PlayerRef->UpdateState(EPlayerStates::Neutral);
 	CharacterMovement->Velocity = FVector::ZeroVector;
 	DetachFromClimbing();
+
+	if (bUseAdaptiveTick)
+	{
+		WakeUp();
+	}
 }
 
 void UClimbingComponent::HasMovedToNewClimbable()
@@ -809,17 +2394,157 @@ void UClimbingComponent::HasMovedToNewClimbable()
 	CurrentClimbable = NextClimbable;
 	NextClimbable = nullptr;
 	MovingTime = 0.0f;
+
+	if (bFollowMovingClimbableRelative && CurrentClimbable->bIsMoving)
+	{
+		StartFollowingMovingClimbable();
+	}
 }
 
-TArray<AClimbable*> UClimbingComponent::ConvertArrayToClimbable(TArray<AActor*> ActorArray)
+bool UClimbingComponent::IsClimbingDecidedHere() const
 {
-	TArray<AClimbable*> Result;
-	for (int i = 0; i < ActorArray.Num(); i++)
+	if (GetNetMode() == NM_Standalone)
 	{
-		Result.Add(Cast<AClimbable>(ActorArray[i]));
+		return true;
 	}
 
-	return Result;
+	auto Pawn = Cast<APawn>(GetOwner());
+	return Pawn != nullptr ? Pawn->IsLocallyControlled() : GetOwnerRole() == ROLE_Authority;
+}
+
+float UClimbingComponent::GetClimbingNetTime() const
+{
+	auto GameState = GetWorld()->GetGameState();
+	return GameState != nullptr ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+}
+
+void UClimbingComponent::UpdateReplicatedClimbState()
+{
+	if (GetOwnerRole() != ROLE_Authority || GetNetMode() == NM_Standalone)
+	{
+		return;
+	}
+
+	ClimbState.Climbable = NextClimbable != nullptr ? NextClimbable : CurrentClimbable;
+	ClimbState.bIsClimbing = IsClimbing();
+	ClimbState.PredictionId = ClimbPredictionId;
+	ClimbState.Sequence++;
+	ClimbState.StartTime = GetClimbingNetTime();
+	ClimbState.StartLocation = BeforeMovingPosition;
+	ClimbState.StartRotation = BeforeMovingRotation;
+	LastAppliedClimbSequence = ClimbState.Sequence;
+
+	// Everyone works out where we are from ClimbState while we climb, so the character's movement doesn't need to be sent every frame.
+	// The owning client is moving itself along the same lerp, there's nothing for the server to correct
+	GetOwner()->SetReplicateMovement(!ClimbState.bIsClimbing);
+	CharacterMovement->bIgnoreClientMovementErrorChecksAndCorrection = ClimbState.bIsClimbing;
+}
+
+void UClimbingComponent::OnRep_ClimbState()
+{
+	if (GetOwnerRole() == ROLE_AutonomousProxy)
+	{
+		// The server hasn't got to our latest guess yet, what it's sending is already out of date
+		if (ClimbState.PredictionId != ClimbPredictionId)
+		{
+			return;
+		}
+
+		// It went the way we guessed, nothing to fix
+		const bool bMatchesPrediction = ClimbState.bIsClimbing
+			? ClimbState.Climbable == NextClimbable || (NextClimbable == nullptr && ClimbState.Climbable == CurrentClimbable)
+			: !IsClimbing();
+		if (bMatchesPrediction)
+		{
+			LastAppliedClimbSequence = ClimbState.Sequence;
+			return;
+		}
+	}
+	else if (ClimbState.Sequence == LastAppliedClimbSequence)
+	{
+		// Only the owning client's prediction id changed
+		return;
+	}
+
+	ApplyReplicatedClimbState();
+}
+
+void UClimbingComponent::ApplyReplicatedClimbState()
+{
+	if (!ClimbState.bIsClimbing)
+	{
+		LastAppliedClimbSequence = ClimbState.Sequence;
+
+		// A mantle lets go by itself once the montage is done
+		if (IsClimbing() && !bIsCurrentlyMantling)
+		{
+			DetachFromClimbingLocally();
+		}
+		return;
+	}
+
+	// The climbable hasn't been mapped on this machine yet, this gets called again once it has
+	if (ClimbState.Climbable == nullptr)
+	{
+		return;
+	}
+
+	LastAppliedClimbSequence = ClimbState.Sequence;
+
+	StartJump(ClimbState.Climbable, GetHangingPosition(ClimbState.Climbable));
+
+	// Pick the lerp up where the server has it, a jump that's already over lands on the next UpdateMovement
+	BeforeMovingPosition = ClimbState.StartLocation;
+	BeforeMovingRotation = ClimbState.StartRotation;
+	MovingTime = FMath::Max(GetClimbingNetTime() - ClimbState.StartTime, 0.0f);
+}
+
+bool UClimbingComponent::IsClimbRequestPlausible(const AClimbable* NewClimbable) const
+{
+	if (NewClimbable == nullptr || bIsCurrentlyMantling)
+	{
+		return false;
+	}
+
+	const auto MaxDistance = FMath::Max3(ClimbingDetectionRadius, GroundClimbingDetectionRadius, InAirClimbingDetectionRadius) +
+		ServerClimbDistanceTolerance;
+	return FVector::DistSquared(NewClimbable->GetActorLocation(), GetOwner()->GetActorLocation()) <= FMath::Square(MaxDistance);
+}
+
+bool UClimbingComponent::ServerAttemptClimb_Validate(AClimbable* NewClimbable, uint8 PredictionId)
+{
+	// Lag can make an honest jump look wrong, so a bad one is turned down rather than getting the client kicked
+	return true;
+}
+
+void UClimbingComponent::ServerAttemptClimb_Implementation(AClimbable* NewClimbable, uint8 PredictionId)
+{
+	ClimbPredictionId = PredictionId;
+
+	// Sending back the prediction id on its own is enough for the client to see it was turned down and catch up
+	ClimbState.PredictionId = PredictionId;
+
+	if (!IsClimbRequestPlausible(NewClimbable) || !AttemptClimb(NewClimbable))
+	{
+		UE_LOG(LogTemp, Verbose, TEXT("Turned down %s's jump to %s"), *GetNameSafe(GetOwner()), *GetNameSafe(NewClimbable));
+	}
+}
+
+bool UClimbingComponent::ServerDetachFromClimbing_Validate(uint8 PredictionId)
+{
+	return true;
+}
+
+void UClimbingComponent::ServerDetachFromClimbing_Implementation(uint8 PredictionId)
+{
+	ClimbPredictionId = PredictionId;
+	ClimbState.PredictionId = PredictionId;
+
+	// We might have let go here already, from the same mantle or obstruction the client saw
+	if (IsClimbing())
+	{
+		DetachFromClimbing();
+	}
 }
 
 bool UClimbingComponent::IsAttached() const { return CurrentClimbable != nullptr; }
@@ -8,9 +8,15 @@
 #include "World/Climbable.h"
 #include "Components/CapsuleComponent.h"
 #include "AI/Navigation/AvoidanceManager.h"
+#include "ClimbingScoring.h"
+#include "ClimbRoutePlanner.h"
+#include "ClimbingRecorder.h"
+#include "ClimbingReplication.h"
+#include "ClimbingDebug.h"
 #include "ClimbingComponent.generated.h"
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FGrabbedNewClimbableDelegate, AClimbable*, AttachedClimbable);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FClimbRouteFinishedDelegate, bool, bSucceeded);
 
 
 UENUM(BlueprintType)
@@ -53,14 +59,17 @@ public:
 	FGrabbedNewClimbableDelegate OnGrabbedNewClimbable;
 	
 
+	/* On an owning client this also tells the server, on the server it's sent on to everyone else*/
 	void DetachFromClimbing();
 	/**
 	 * \brief 
 	 * \param InputDirection (Up by default) The direction in which we want to climb towards
+	 * \param bCanWaitForAsyncQueries If the best climbable's async obstruction result hasn't come back yet, return nothing
+	 * and try again next frame instead of doing the query right away. Only used with bUseAsyncObstructionQueries.
 	 * \return The best Climbable to move to!
 	 */
 
-	AClimbable* FindBestClimbable(FVector2D InputDirection, EClimableDetectionTypeEnum DetectionType);
+	AClimbable* FindBestClimbable(FVector2D InputDirection, EClimableDetectionTypeEnum DetectionType, bool bCanWaitForAsyncQueries = false);
 
 	FTransform GetHangingPosition(const AActor* NewClimbable);
 
@@ -92,16 +101,89 @@ public:
 	* \return Is the player currently attached to a moving climbable.
 	*/
 	bool IsOnMovingClimbable() const;
+
+	/**
+	 * \brief Starts planning a route of climbables to Target, spread over the next few ticks. OnClimbRouteFinished fires once it's done.
+	 * This is for AI climbers, so they don't have to guess input directions for FindBestClimbable.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Climbing|Route")
+	void RequestClimbRoute(AClimbable* Target);
+
+	/* Same as RequestClimbRoute, but to any climbable within AcceptanceRadius of Location*/
+	UFUNCTION(BlueprintCallable, Category = "Climbing|Route")
+	void RequestClimbRouteToLocation(FVector Location, float AcceptanceRadius = 200.0f);
+
+	UFUNCTION(BlueprintCallable, Category = "Climbing|Route")
+	void CancelClimbRoute();
+
+	/* Jumps to the next climbable on the route, unless we're in the middle of a jump. Returns false if there's nothing to jump to.*/
+	UFUNCTION(BlueprintCallable, Category = "Climbing|Route")
+	bool ClimbAlongRoute();
+
+	UFUNCTION(BlueprintPure, Category = "Climbing|Route")
+	EClimbRouteStatusEnum GetClimbRouteStatus() const { return ClimbRouteStatus; }
+
+	/* The climbables still left to jump to, in order*/
+	UFUNCTION(BlueprintPure, Category = "Climbing|Route")
+	const TArray<AClimbable*>& GetClimbRoute() const { return ClimbRoute; }
+
+	/* Fires when route planning finishes, and again whenever a moving climbable forces the route to be planned over*/
+	UPROPERTY(BlueprintAssignable, Category = "Climbing|Route")
+	FClimbRouteFinishedDelegate OnClimbRouteFinished;
+
+	/* Starts writing what climbing reads every tick to Filename, so it can be played back with StartClimbingReplay*/
+	bool StartClimbingRecording(const FString& Filename);
+
+	void StopClimbingRecording();
+
+	/**
+	 * \brief Feeds a recording back through DetectClimbables and FindBestClimbable, one recorded tick per frame, with the normal tick
+	 * switched off. Once it's done it logs how long that took and anywhere a different climbable came out than when it was recorded.
+	 */
+	bool StartClimbingReplay(const FString& Filename);
+
+	void StopClimbingReplay();
+
+	/* Puts the component back on a full rate tick, if adaptive ticking had slowed it down or put it to sleep*/
+	void WakeUp();
+
+	/* What the hanging capsule gets checked against when looking for obstructions*/
+	static const FCollisionObjectQueryParams& GetObstructionObjectParams();
+
+	/* True if the overlapped component would stop Mokosh from hanging there*/
+	static bool DoesOverlapBlockClimbing(const FOverlapResult& Overlap);
+
+	/* True if the component is something the obstruction checks would find and be stopped by*/
+	static bool CanComponentBlockClimbing(const UPrimitiveComponent* Primitive);
+
+#if WITH_CLIMBING_DEBUG
+	/* The Gameplay Debugger calls this every frame it's showing us, the snapshot is only filled in while something keeps asking*/
+	const FClimbingDebugSnapshot& RequestDebugSnapshot();
+#endif
 	
 
 protected:
 
 	// Called when the game starts
 	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 	
 	UFUNCTION()
 	void ClimbingMontageFinished(class UAnimMontage* Montage, bool bInterrupted);
 
+	/* The owning client has already started this jump, PredictionId comes back in ClimbState once the server has looked at it*/
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerAttemptClimb(AClimbable* NewClimbable, uint8 PredictionId);
+
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerDetachFromClimbing(uint8 PredictionId);
+
+	UFUNCTION()
+	void OnRep_ClimbState();
+
 
 public:
 
@@ -112,10 +194,26 @@ public:
 	void RunAgainstWallChecker();
 	
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/**
+	 * The tick in three parts, so that the climbable subsystem can run every climber's ComputeTick at once on worker threads when
+	 * bUseBatchedTick is set. BeginTick handles the early outs and reads what ComputeTick needs from the player, the timers and the
+	 * input. ComputeTick detects the climbables around us, picks the one we'd fly forward onto and fills in TickCommands, only going
+	 * through the subsystem's queries. ApplyTick carries TickCommands out along with everything that changes the actor, the player,
+	 * timers or the subsystem. TickComponent just calls all three when the tick isn't batched.
+	 * \return BeginTick returns false if the tick was finished early, in which case the other two don't need calling
+	 */
+	bool BeginTick(float DeltaTime, ELevelTick TickType);
+	void ComputeTick(float DeltaTime);
+	void ApplyTick(float DeltaTime, ELevelTick TickType);
 	
 	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Climbing")
 	UCurveFloat* MovementCurve;
 	
+	/* Sweeps the capsule from where we are to where we'd hang before jumping, and doesn't jump if something is in the way*/
+	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Climbing")
+	bool bSweepJumpPath = false;
+	
 	/* The value at which in the dot product calculation the animation switches from left/right to up*/
 	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Tunables\|Animation")
 	float ClimbingAnimDotProductDifference = 0.5f;
@@ -156,6 +254,77 @@ public:
 	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Detection")
 	float TimeRunningAgainstWallToTryGrab = 0.1f;
 	
+	/* The most climbables route planning expands in one tick, the shared Climbing.RoutePlanningBudget can make it fewer*/
+	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Route", meta = (ClampMin = "1"))
+	int32 MaxRouteExpansionsPerTick = 32;
+	
+	/* Route planning gives up after seeing this many climbables*/
+	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Route", meta = (ClampMin = "1"))
+	int32 MaxRouteSearchNodes = 2048;
+	
+	/* While on a moving climbable, work out the hanging transform once relative to it and follow along with one transform update a tick*/
+	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Hanging\|Moving")
+	bool bFollowMovingClimbableRelative = true;
+	
+	/* How far a moving climbable can carry us before we check that we're not being pushed into something*/
+	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Hanging\|Moving", meta = (ClampMin = "0.0"))
+	float MovingClimbableRevalidateDistance = 50.0f;
+	
+	/* Same as MovingClimbableRevalidateDistance, but for how far it turns, in degrees*/
+	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Hanging\|Moving", meta = (ClampMin = "0.0"))
+	float MovingClimbableRevalidateAngle = 10.0f;
+	
+	/* Lets detection reuse the last query's climbables while the player has barely moved, instead of querying every tick*/
+	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Detection\|Incremental")
+	bool bUseIncrementalDetection = true;
+
+	/* How far the detection origin can move, as a fraction of the detection radius, before we query for climbables again*/
+	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Detection\|Incremental", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float IncrementalDetectionRefreshFraction = 0.1f;
+	
+	/* Remembers obstruction checks on climbables that don't move, until something that could block Mokosh moves through them*/
+	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Detection")
+	bool bUseObstructionCache = true;
+	
+	/* Slows the tick down when there's nothing to climb around, and stops it altogether when we're away from every climbable cluster*/
+	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Ticking")
+	bool bUseAdaptiveTick = false;
+	
+	/* The tick interval used while there's nothing to climb close by*/
+	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Ticking", meta = (ClampMin = "0.0"))
+	float IdleTickInterval = 0.1f;
+	
+	/* Hands the tick over to the climbable subsystem, which detects and rates every climber's candidates together on worker threads*/
+	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Ticking")
+	bool bUseBatchedTick = false;
+	
+	/* While attached to a static climbable, take the candidates from the level's baked AClimbingGraph when there's an up to date one*/
+	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Detection\|Graph")
+	bool bUseBakedClimbingGraph = true;
+	
+	/* Shares detection queries with other climbers in the same area this frame, turn this on for co-op players and AI creatures*/
+	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Detection")
+	bool bUseSharedDetection = false;
+	
+	/* Obstruction checks are sent off at the end of the tick and picked up on the next one, instead of blocking the game thread*/
+	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Detection\|Async")
+	bool bUseAsyncObstructionQueries = false;
+	
+	/* How many climbables can have an async obstruction check sent off each frame*/
+	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Detection\|Async", meta = (ClampMin = "1"))
+	int32 MaxAsyncObstructionQueriesPerFrame = 8;
+	
+	/* How many frames an async obstruction result can be used for before it needs to be checked again*/
+	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Detection\|Async", meta = (ClampMin = "1"))
+	int32 AsyncObstructionResultLifetime = 4;
+	
+	/**
+	 * Gathers the collision around all the candidates with one broadphase query the first time FindBestClimbable needs an obstruction
+	 * check, then tests each hanging capsule against just those components. Only used for the checks that aren't async.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Detection\|Batched")
+	bool bUseBatchedObstructionQueries = false;
+	
 	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Detection\|FlyingForward", meta = (DisplayName = "Capsule Height Detection"))
 	float FlyingForwardCapsuleHeight = 45.0f;
 	
@@ -165,6 +334,30 @@ public:
 	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Detection\|FlyingForward")
 	FVector CapsuleOffset = FVector();
 	
+	/**
+	 * Gathers the climbables along the arc we're flying on ahead of time, and checks the stretch we'll cover before the next tick
+	 * instead of just where we are. Fast throws can't skip past a climbable between ticks, without making the capsule any bigger.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Detection\|Prediction")
+	bool bUsePredictivePrefetch = true;
+	
+	/* How far ahead, in seconds, the arc gets gathered*/
+	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Detection\|Prediction", meta = (ClampMin = "0.0"))
+	float PredictivePrefetchTime = 0.3f;
+	
+	/* How many straight pieces the arc gets split into*/
+	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Detection\|Prediction", meta = (ClampMin = "1"))
+	int32 PredictivePrefetchSteps = 6;
+	
+	/* How far off the predicted arc we can end up, say from air control or bumping into something, before it's gathered again*/
+	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Detection\|Prediction", meta = (ClampMin = "0.0"))
+	float PredictivePrefetchTolerance = 50.0f;
+	
+	/* How much further than the detection radius the server lets a client jump, to make up for lag*/
+	UPROPERTY(EditDefaultsOnly, Category = "Tunables\|Networking", meta = (ClampMin = "0.0"))
+	float ServerClimbDistanceTolerance = 500.0f;
+	
+	/* Keeps the debug snapshot filled in even when the Gameplay Debugger isn't showing us. Does nothing in Shipping and Test builds.*/
 	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category = "Tunables\|Debugging")
 	bool bIsDebugging = false;
 	
@@ -184,6 +377,8 @@ public:
 
 private:
 
+	friend class FGameplayDebuggerCategory_Climbing;
+
 	enum ECharacterStateEnum
 	{
 		CCS_OnGround, CCS_Climbing, CCS_Falling
@@ -196,6 +391,169 @@ private:
 	
 	UPROPERTY()
 	TArray<AClimbable*> PossibleClimbables;
+
+	/* Where each of the PossibleClimbables lives in the climbable subsystem's mirror*/
+	TArray<int32> PossibleClimbableSlots;
+
+	/* Set when the PossibleClimbables started out from a baked graph*/
+	bool bDetectedFromGraph = false;
+
+	/* How many of the PossibleClimbables, from the start, are the graph's own neighbours. Those were checked for obstructions when it was
+	 * baked, anything after them came from across a level seam or is moving, and still has to be checked*/
+	int32 NumBakedCandidates = 0;
+
+	/* The climbables along the arc we were flying on when it was last gathered*/
+	struct FTrajectoryPrefetch
+	{
+		TArray<AClimbable*> Climbables;
+		TArray<int32> Slots;
+		TArray<FBox> Bounds;
+
+		FVector StartLocation = FVector::ZeroVector;
+		FVector StartVelocity = FVector::ZeroVector;
+		float GravityZ = 0.0f;
+		float StartTime = 0.0f;
+		float Duration = 0.0f;
+		uint32 Generation = 0;
+		bool bIsValid = false;
+
+		FVector GetPredictedLocation(float Time) const;
+	};
+
+	FTrajectoryPrefetch TrajectoryPrefetch;
+
+	/* Scratch space for the points along the arc*/
+	TArray<FVector> TrajectoryPoints;
+
+	/* Kept around between calls so FindBestClimbable doesn't need to reallocate*/
+	FClimbableScoringBatch ScoringBatch;
+	TArray<int32> CandidateHeap;
+
+	/* Scratch space for IsPlayerCapsuleInsideCollision*/
+	TArray<FOverlapResult> ObstructionOverlaps;
+
+	/* Scratch space for IsJumpPathBlocked*/
+	TArray<FHitResult> JumpPathHits;
+
+	/* The blocking collision around this FindBestClimbable call's candidates, for bUseBatchedObstructionQueries*/
+	struct FObstructionBatch
+	{
+		/* Covers every candidate's hanging capsule, a capsule outside of it gets its own query*/
+		FBox Region = FBox(ForceInit);
+
+		/* Only valid until FindBestClimbable returns*/
+		TArray<UPrimitiveComponent*> Primitives;
+		TArray<FBox> Bounds;
+		bool bIsGathered = false;
+
+		void Reset();
+	};
+
+	FObstructionBatch ObstructionBatch;
+
+	FClimbRoutePlanner RoutePlanner;
+
+	EClimbRouteStatusEnum ClimbRouteStatus = EClimbRouteStatusEnum::CRS_None;
+
+	UPROPERTY()
+	TArray<AClimbable*> ClimbRoute;
+
+	/* What the route was asked to get to, kept for replanning*/
+	TWeakObjectPtr<AClimbable> RouteGoalClimbable;
+	bool bHasRouteGoalClimbable = false;
+	FVector RouteGoalLocation = FVector::ZeroVector;
+	float RouteGoalRadius = 0.0f;
+
+	/* The climbable subsystem's generation when planning started, if it changes the search has to start over*/
+	uint32 RoutePlanningGeneration = 0;
+
+	/* What UpdateMovement needs for the jump to NextClimbable, worked out once in AttemptClimb*/
+	struct FPrecomputedJump
+	{
+		/* MovementCurve baked into a table, shared with everyone else using the same curve*/
+		TSharedPtr<const struct FClimbingCurveTable> Curve;
+
+		/* When false the end is still looked up every tick, since it changes while we're in the air*/
+		bool bHasFixedEnd = false;
+		FVector EndLocation = FVector::ZeroVector;
+		FRotator EndRotation = FRotator::ZeroRotator;
+	};
+
+	FPrecomputedJump Jump;
+
+	/* Goes up with every StartJump, so a jump worked out ahead of time can tell it's been replaced*/
+	uint32 NumJumpsStarted = 0;
+
+	/* One step of the jump to NextClimbable*/
+	struct FJumpStep
+	{
+		uint32 JumpNumber = 0;
+		float MovingTime = 0.0f;
+		float Alpha = 0.0f;
+		bool bIsFinished = false;
+
+		/* Only set when the jump has a fixed end, otherwise the end is looked up when the step is applied*/
+		bool bHasTransform = false;
+		FVector Location = FVector::ZeroVector;
+		FRotator Rotation = FRotator::ZeroRotator;
+	};
+
+	/* What RunAgainstWallChecker decided to do with the auto grab timer*/
+	struct FWallTimerStep
+	{
+		enum class ETimerAction : uint8
+		{
+			Keep, Start, Clear
+		};
+
+		ETimerAction TimerAction = ETimerAction::Keep;
+		bool bIsHoldingDownForward = false;
+		bool bHoldingForwardDoCheck = false;
+	};
+
+	/* What ComputeTick worked out, for ApplyTick to carry out*/
+	struct FClimbingTickCommands
+	{
+		bool bIsFlyingForwardInAir = false;
+		FWallTimerStep WallTimer;
+
+		/* Only set while a jump with a movement curve was under way, otherwise UpdateMovement works it out in ApplyTick*/
+		bool bHasJumpStep = false;
+		FJumpStep JumpStep;
+
+		/* Set when ApplyTick is going to look for something to fly forward onto, which is then picked in ComputeTick*/
+		bool bHasForwardPick = false;
+		AClimbable* ForwardPick = nullptr;
+
+		/* NumJumpsStarted when the pick was made, it's stale once we've jumped since*/
+		uint32 ForwardPickJumpNumber = 0;
+	};
+
+	FClimbingTickCommands TickCommands;
+
+	/* What ComputeTick needs from the timer manager and the input, which BeginTick reads for it*/
+	struct FClimbingTickInputs
+	{
+		bool bIsAutoGrabTimerActive = false;
+		float ForwardInput = 0.0f;
+	};
+
+	FClimbingTickInputs TickInputs;
+
+	/* The server's climbing, sent whenever a jump starts or we let go*/
+	UPROPERTY(ReplicatedUsing = OnRep_ClimbState)
+	FReplicatedClimbState ClimbState;
+
+	/* On the owning client this is the last jump or let go it guessed at, on the server the last one it was told about*/
+	uint8 ClimbPredictionId = 0;
+
+	/* The ClimbState.Sequence that was last played back here*/
+	uint8 LastAppliedClimbSequence = 0;
+
+	/* Scratch space for GatherRouteNeighbours*/
+	TArray<AClimbable*> RouteCandidates;
+	TArray<int32> RouteReachable;
+	FClimbableScoringBatch RouteScoringBatch;
 	
 	/*The climbable we're currently on*/
 	UPROPERTY()
@@ -207,6 +565,128 @@ private:
 
 	ECharacterStateEnum CharacterState = CCS_OnGround;
 
+	enum class EObstructionResult : uint8
+	{
+		Clear, Obstructed, Pending
+	};
+
+	/* An obstruction check that was sent off on an earlier frame, along with where the hanging capsule was when it was sent*/
+	struct FAsyncObstructionResult
+	{
+		TWeakObjectPtr<AClimbable> Climbable;
+		FVector HangingLocation = FVector::ZeroVector;
+		FQuat HangingRotation = FQuat::Identity;
+		uint64 Frame = 0;
+		bool bIsObstructed = false;
+		bool bIsPending = false;
+	};
+
+	/* Keyed on the climbable's unique id, since that's what comes back with the overlap. Anything that stops being a candidate is dropped.*/
+	TMap<uint32, FAsyncObstructionResult> AsyncObstructionResults;
+
+	/* Climbables that FindBestClimbable had to wait on, these are sent off before anything else*/
+	TArray<AClimbable*> AsyncObstructionPriority;
+
+	/* Where we got to in PossibleClimbables last time, so every candidate eventually gets checked*/
+	int32 AsyncObstructionCursor = 0;
+
+	FOverlapDelegate AsyncObstructionDelegate;
+
+	TUniquePtr<FClimbingRecorder> Recorder;
+
+	/* Scratch space for recording where the moving climbables are each tick*/
+	TArray<AClimbable*> RecordedMovingClimbables;
+
+	/* A recording being played back, this takes over from the normal tick until it's done*/
+	struct FClimbingReplay
+	{
+		FClimbingRecording Recording;
+		TArray<AClimbable*> Climbables;
+		TMap<const AClimbable*, int32> ClimbableIndices;
+		int32 NextFrame = 0;
+
+		/* What IsMovingOnGround returns while replaying*/
+		bool bIsMovingOnGround = false;
+
+		/* Put back once the replay is done*/
+		bool bWasUsingAsyncObstructionQueries = false;
+		bool bWasMovementTickEnabled = true;
+
+		int32 NumDetections = 0;
+		int32 NumDetectionMismatches = 0;
+		int32 NumQueries = 0;
+		int32 NumQueryMismatches = 0;
+
+		/* Milliseconds spent in DetectClimbables and FindBestClimbable for each recorded tick*/
+		TArray<double> FrameTimes;
+
+		FDelegateHandle TickerHandle;
+
+		AClimbable* GetClimbable(int32 Index) const { return Climbables.IsValidIndex(Index) ? Climbables[Index] : nullptr; }
+		int32 GetClimbableIndex(const AClimbable* Climbable) const;
+	};
+
+	TUniquePtr<FClimbingReplay> Replay;
+
+	/* Every synchronous obstruction check so far, stat Climbing uses it to work out how many a button press cost*/
+	uint32 NumObstructionQueries = 0;
+
+#if WITH_CLIMBING_DEBUG
+	TUniquePtr<FClimbingDebugSnapshot> DebugSnapshot;
+#endif
+
+	/* Hanging transforms for static crystals, these only change if the crystal, the capsule or the tunables do*/
+	struct FCachedHangingTransform
+	{
+		TWeakObjectPtr<const AActor> Climbable;
+
+		/* Where the climbable was when this was worked out, if it's been moved since the cached result is thrown away*/
+		FTransform ClimbableTransform;
+		FTransform Transform;
+		FVector CapsuleUp = FVector::ZeroVector;
+		float CapsuleHalfHeight = 0.0f;
+		float CapsuleRadius = 0.0f;
+		FVector DistanceFromClimbTarget = FVector::ZeroVector;
+	};
+
+	/* Entries are thrown away when their climbable leaves the climbable subsystem*/
+	TMap<const AActor*, FCachedHangingTransform> HangingTransformCache;
+
+	/* Reserved in BeginPlay, once it fills up it starts over instead of growing, so caching never allocates*/
+	static constexpr int32 MaxCachedHangingTransforms = 64;
+
+	void OnClimbableUnregistered(const AClimbable* Climbable);
+
+	/* The hanging transform in the space of the moving climbable we're on, worked out once when we get there*/
+	struct FMovingClimbableFollow
+	{
+		TWeakObjectPtr<const AClimbable> Climbable;
+		FTransform RelativeHangingTransform;
+
+		/* Where the climbable was the last time we checked for obstructions*/
+		FTransform ValidatedClimbableTransform;
+	};
+
+	FMovingClimbableFollow MovingClimbableFollow;
+
+	/* The result of the last detection query, made a bit bigger than needed so that it stays valid while we move around inside it*/
+	struct FDetectionCache
+	{
+		TArray<AClimbable*> Climbables;
+		TArray<int32> Slots;
+		TArray<FBox> Bounds;
+		FVector Origin = FVector::ZeroVector;
+		float Radius = 0.0f;
+		float QueryRadius = 0.0f;
+		ECharacterStateEnum CharacterState = CCS_OnGround;
+		const AActor* IgnoredCurrentClimbable = nullptr;
+		const AActor* IgnoredNextClimbable = nullptr;
+		uint32 Generation = 0;
+		bool bIsValid = false;
+	};
+
+	FDetectionCache DetectionCache;
+
 	// reference to mokosh to update player state
 	class AMokosh* PlayerRef;
 
@@ -226,8 +706,138 @@ private:
 	void CalculateCharacterState();
 	
 	void AutoGrabChecker();
-	
-	TArray<AClimbable*> ConvertArrayToClimbable(TArray<AActor*> ActorArray);
+
+	/* The part of FindBestClimbable that does the work, without the recording*/
+	AClimbable* SelectBestClimbable(FVector2D InputDirection, EClimableDetectionTypeEnum DetectionType, bool bCanWaitForAsyncQueries);
+
+	/* The rest of FindBestClimbable, which has to be on the game thread*/
+	AClimbable* RecordBestClimbable(AClimbable* BestClimbable, FVector2D InputDirection, EClimableDetectionTypeEnum DetectionType,
+	                                bool bCanWaitForAsyncQueries);
+
+	/* FindBestClimbable for flying forward, reusing what ComputeTick picked as long as we haven't jumped since*/
+	AClimbable* FindBestForwardInAirClimbable();
+
+	/* The part of DetectClimbables that goes through the subsystem's queries, without updating CharacterState*/
+	void GatherClimbables(bool bFlyingForwardInAir);
+
+	/* CharacterMovement->IsMovingOnGround(), or what it was in the recording while replaying*/
+	bool IsMovingOnGround() const;
+
+	/* What FindBestClimbable and DetectClimbables are working from right now, in the form the recorder writes it out*/
+	FClimbingRecordedState GetRecordedState();
+
+	void ApplyRecordedState(const FClimbingRecordedState& State);
+
+	/* Plays back the next recorded tick, returns false once there's nothing left*/
+	bool TickClimbingReplay(float DeltaTime);
+
+	/* Logs the timings and mismatches for the replay so far*/
+	void ReportClimbingReplay() const;
+
+	/* Picks the tick rate for the next frame when bUseAdaptiveTick is set*/
+	void UpdateAdaptiveTick();
+
+	/* The early outs at the top of the tick, returns true if there's nothing more to do this tick*/
+	bool FinishTickEarly(float DeltaTime, ELevelTick TickType);
+
+	/* The part of RunAgainstWallChecker that doesn't touch the timer*/
+	void ComputeWallTimerStep(const FVector& LocalVelocity, const FClimbingTickInputs& Inputs, FWallTimerStep& OutStep) const;
+
+	FClimbingTickInputs GetTickInputs() const;
+	void ApplyWallTimerStep(const FWallTimerStep& Step);
+
+	/* Needs a jump under way and MovementCurve to be set*/
+	void ComputeJumpStep(float DeltaTime, FJumpStep& OutStep) const;
+	void ApplyJumpStep(const FJumpStep& Step);
+
+	/* Starts the route search over from where we are now, towards the last requested goal*/
+	void StartClimbRoutePlanning();
+
+	/* Steps the route search, or checks that a finished route can still be climbed*/
+	void UpdateClimbRoute();
+
+	/* False if a jump on the route is gone, or a moving climbable has carried it out of reach*/
+	bool IsClimbRouteStillValid() const;
+
+	/* Where the route planner can go from From, which is nullptr for the ground at FromLocation*/
+	void GatherRouteNeighbours(class UClimbableSubsystem* ClimbableSubsystem, AClimbable* From, const FVector& FromLocation,
+		TArray<AClimbable*>& OutNeighbours);
+
+	FClimbReachabilitySettings GetClimbReachabilitySettings() const;
+
+	/* True if the capsule would hit something that blocks Mokosh on the way from where we are to HangingTransform*/
+	bool IsJumpPathBlocked(const AClimbable* NewClimbable, const FTransform& HangingTransform);
+
+	/* Everything about starting a jump that's the same whether we decided on it or the server told us about it*/
+	void StartJump(AClimbable* NewClimbable, const FTransform& HangingTransform);
+
+	/* Lets go without telling anyone*/
+	void DetachFromClimbingLocally();
+
+	/* False on the server for a client's character and on everyone else's copy of it, those only play back ClimbState*/
+	bool IsClimbingDecidedHere() const;
+
+	/* Called on the server after a jump starts or we let go, so it gets sent out*/
+	void UpdateReplicatedClimbState();
+
+	/* Starts the jump in ClimbState, partway through if it started on the server a while ago*/
+	void ApplyReplicatedClimbState();
+
+	/* False if a client asked for a jump it couldn't have seen from where the server has it*/
+	bool IsClimbRequestPlausible(const AClimbable* NewClimbable) const;
+
+	/* The server's world time, which is what ClimbState.StartTime is in*/
+	float GetClimbingNetTime() const;
+
+	/* Keeps us hanging off CurrentClimbable while it moves, dropping off if it carries us into something*/
+	void FollowMovingClimbable();
+
+	/* Puts the hanging transform for CurrentClimbable into its space, for FollowMovingClimbable*/
+	void StartFollowingMovingClimbable();
+
+	/* Uses the async result when there's a fresh one, otherwise either does the query right away or reports that it's pending*/
+	EObstructionResult GetObstruction(AClimbable* Climbable, bool bCanWaitForAsyncQueries);
+
+	/* Sends off overlap queries for the candidates that will most likely be needed next frame*/
+	void IssueAsyncObstructionQueries();
+
+	bool IssueAsyncObstructionQuery(AClimbable* Climbable);
+
+	void OnAsyncObstructionOverlap(const FTraceHandle& TraceHandle, FOverlapDatum& OverlapDatum);
+
+	/* True if the capsule would be inside something that blocks Mokosh at Transform*/
+	bool IsCapsuleObstructedAt(const FTransform& Transform);
+
+	/* Same as IsCapsuleObstructedAt, but against ObstructionBatch, which gets gathered the first time it's needed*/
+	bool IsCapsuleObstructedInBatch(const FTransform& Transform, const FCollisionShape& Capsule);
+
+	void GatherObstructionBatch();
+
+	/* True if any of the overlaps blocks Mokosh*/
+	bool IsAnyOverlapBlocking(const TArray<FOverlapResult>& Overlaps) const;
+
+	/* The uncached part of GetHangingPosition*/
+	FTransform ComputeHangingPosition(const AActor* NewClimbable);
+
+	/* Same as above, but for the capsule pointing along CapsuleUp instead of the way it is now*/
+	FTransform ComputeHangingPosition(const AActor* NewClimbable, const FVector& CapsuleUp);
+
+	/* Goes through the climbable subsystem, so that repeated lookups on the same ledge in a frame are only done once*/
+	FTransform GetLedgeClimbUpTransform(const class ASplineLedge* Ledge) const;
+
+	/* Sphere query against the climbable index, shared with other climbers when bUseSharedDetection is set*/
+	bool QueryClimbableSphere(class UClimbableSubsystem* ClimbableSubsystem, const FVector& Center, float Radius, TArrayView<AActor* const> IgnoreList,
+		TArray<AClimbable*>& OutClimbables, TArray<int32>* OutSlots, TArray<FBox>* OutBounds = nullptr) const;
+
+	/* Gathers the climbables along the arc we're flying on again, unless the last arc is still good*/
+	void UpdateTrajectoryPrefetch(class UClimbableSubsystem* ClimbableSubsystem, const FVector& CastPosition, TArrayView<AActor* const> IgnoreList);
+
+	/* The forward in air check against the prefetched climbables, covering everywhere the capsule gets to before the next tick*/
+	bool DetectClimbablesPredictive(class UClimbableSubsystem* ClimbableSubsystem, const FVector& CastPosition, TArrayView<AActor* const> IgnoreList);
+
+	/* Fills PossibleClimbables from DetectionCache, only hitting the climbable index again when the cache is stale*/
+	bool DetectClimbablesIncremental(class UClimbableSubsystem* ClimbableSubsystem, const FVector& CastTarget, float DetectionRadius,
+		TArrayView<AActor* const> IgnoreList);
 	
 	/* Gets the direction that the the player is jumping towards*/
 	EClimbingDirectionEnum GetDirection(AActor* Origin, AClimbable* TheClimbable) const;
@@ -0,0 +1,310 @@
+/* Copyright 2019 Alexandrea Shackelford, Zion Nimchuk, All Rights Reserved.
+ * Unauthorized copying or modification of this file, via any medium is strictly prohibited.
+ */
+
+#include "ClimbingCore.h"
+#include <cfloat>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+	#define CLIMBING_CORE_SSE 1
+	#include <emmintrin.h>
+#else
+	#define CLIMBING_CORE_SSE 0
+#endif
+
+namespace ClimbingCore
+{
+	namespace
+	{
+		constexpr float RadiansToDegrees = 57.2957795130823208768f;
+
+		/* Same as the Rating assignments in the old FindBestClimbable loop*/
+		inline float RateCandidate(const FScoringParams& Params, float RelativeX, float RelativeY)
+		{
+			if (!Params.bIsForwardInAir)
+			{
+				// We prefer going towards the positive X direction, and any saps that are farther to the left or right are not preferred
+				return (RelativeX * 0.5f + 1.0f) - std::fabs(RelativeY) * 0.1f;
+			}
+
+			// If we're going forward in air, then the center is actually the preferred position
+			return (60.0f - std::fabs(RelativeX) * 0.1f) - std::fabs(RelativeY) * 0.1f;
+		}
+
+#if CLIMBING_CORE_SSE
+		/* FindDeltaAngleDegrees, four at a time*/
+		inline __m128 FindDeltaAngleDegrees4(__m128 A1, __m128 A2)
+		{
+			const auto Full = _mm_set1_ps(360.0f);
+			auto Delta = _mm_sub_ps(A2, A1);
+			Delta = _mm_sub_ps(Delta, _mm_and_ps(_mm_cmpgt_ps(Delta, _mm_set1_ps(180.0f)), Full));
+			Delta = _mm_add_ps(Delta, _mm_and_ps(_mm_cmplt_ps(Delta, _mm_set1_ps(-180.0f)), Full));
+			return Delta;
+		}
+
+		inline __m128 Abs4(__m128 Value)
+		{
+			return _mm_andnot_ps(_mm_set1_ps(-0.0f), Value);
+		}
+
+		/* Dot product of four deltas against one axis, multiply then add so it matches the scalar path exactly*/
+		inline __m128 Dot4(__m128 DeltaX, __m128 DeltaY, __m128 DeltaZ, const FVec3& Axis)
+		{
+			auto Result = _mm_mul_ps(DeltaX, _mm_set1_ps(Axis.X));
+			Result = _mm_add_ps(Result, _mm_mul_ps(DeltaY, _mm_set1_ps(Axis.Y)));
+			Result = _mm_add_ps(Result, _mm_mul_ps(DeltaZ, _mm_set1_ps(Axis.Z)));
+			return Result;
+		}
+#endif
+	}
+
+	FScoringParams MakeScoringParams(const FScoringInputs& Inputs)
+	{
+		FScoringParams Params;
+		Params.Origin = Inputs.Origin;
+		Params.LocalAxisX = Inputs.LocalAxisX;
+		Params.DirectionAxisX = Inputs.DirectionAxisX;
+		Params.DirectionAxisY = Inputs.DirectionAxisY;
+		Params.OwnerYaw = Inputs.OwnerYaw;
+		Params.OwnerPitch = Inputs.OwnerPitch;
+
+		const bool bIsForwardInAir = Inputs.DetectionType == EDetectionType::ForwardInAir;
+
+		// We don't want to check for saps directly below us if we're not climbing
+		Params.bRejectBelow = Inputs.DetectionType != EDetectionType::IsClimbing;
+		Params.MinimumZ = Inputs.Origin.Z - Inputs.CapsuleHalfHeight;
+
+		// If it's behind us, we can't climb onto it.
+		// We don't really need to preform this check while we're climbing
+		Params.bRejectBehind = !bIsForwardInAir && !Inputs.bIsAttached;
+
+		// If we're attempting to auto climb on wall, then we want a different distance than usual
+		Params.MaxLocalX = FLT_MAX;
+		if (bIsForwardInAir)
+		{
+			Params.MaxLocalX = Inputs.MaxForwardThrownDistance;
+		}
+		// Even though we do a circle cast, we don't want the player to be able to reach the full extent of the
+		else if (Inputs.bIsOnGround)
+		{
+			Params.MaxLocalX = Inputs.MaxForwardGroundJumpDistance;
+		}
+
+		// Fancy directional check, for each of the saps we compare it against the forward direction of the input
+		Params.bRejectOutsideDirection = !bIsForwardInAir;
+		Params.MaxYawDelta = Inputs.MaxYawDelta;
+		Params.MaxPitchDelta = Inputs.MaxPitchDelta;
+		Params.bIsForwardInAir = bIsForwardInAir;
+
+		return Params;
+	}
+
+	void ScoreCandidatesScalar(const FScoringParams& Params, const FCandidateArrays& Candidates, int Start, int End)
+	{
+		for (int i = Start; i < End; i++)
+		{
+			Candidates.Ratings[i] = 0.0f;
+
+			if (Candidates.Eligible[i] == 0.0f)
+			{
+				continue;
+			}
+
+			const FVec3 Delta = FVec3(Candidates.PositionX[i], Candidates.PositionY[i], Candidates.PositionZ[i]) - Params.Origin;
+			const auto LocalX = FVec3::Dot(Delta, Params.LocalAxisX);
+			const auto RelativeX = FVec3::Dot(Delta, Params.DirectionAxisX);
+			const auto RelativeY = FVec3::Dot(Delta, Params.DirectionAxisY);
+
+			if (Params.bRejectBelow && Candidates.PositionZ[i] < Params.MinimumZ)
+			{
+				continue;
+			}
+
+			if (Params.bRejectBehind && LocalX < 0)
+			{
+				continue;
+			}
+
+			if (LocalX > Params.MaxLocalX)
+			{
+				continue;
+			}
+
+			if (Params.bRejectOutsideDirection && RelativeX <= 0)
+			{
+				continue;
+			}
+
+			if (FindDeltaAngleDegrees(Params.OwnerYaw, Candidates.Yaw[i]) > Params.MaxYawDelta)
+			{
+				continue;
+			}
+
+			if (FindDeltaAngleDegrees(Params.OwnerPitch, Candidates.Pitch[i]) > Params.MaxPitchDelta)
+			{
+				continue;
+			}
+
+			Candidates.Ratings[i] = RateCandidate(Params, RelativeX, RelativeY);
+		}
+	}
+
+	void ScoreCandidates(const FScoringParams& Params, const FCandidateArrays& Candidates, int Start, int End)
+	{
+#if CLIMBING_CORE_SSE
+		const auto Zero = _mm_setzero_ps();
+		const auto OriginX = _mm_set1_ps(Params.Origin.X);
+		const auto OriginY = _mm_set1_ps(Params.Origin.Y);
+		const auto OriginZ = _mm_set1_ps(Params.Origin.Z);
+		const auto OwnerYaw = _mm_set1_ps(Params.OwnerYaw);
+		const auto OwnerPitch = _mm_set1_ps(Params.OwnerPitch);
+		const auto MinimumZ = _mm_set1_ps(Params.MinimumZ);
+		const auto MaxLocalX = _mm_set1_ps(Params.MaxLocalX);
+		const auto MaxYawDelta = _mm_set1_ps(Params.MaxYawDelta);
+		const auto MaxPitchDelta = _mm_set1_ps(Params.MaxPitchDelta);
+		const auto Half = _mm_set1_ps(0.5f);
+		const auto Tenth = _mm_set1_ps(0.1f);
+		const auto One = _mm_set1_ps(1.0f);
+		const auto ForwardInAirBase = _mm_set1_ps(60.0f);
+
+		for (int i = Start; i < End; i += FCandidateArrays::VectorWidth)
+		{
+			const auto PositionZ = _mm_loadu_ps(Candidates.PositionZ + i);
+			const auto DeltaX = _mm_sub_ps(_mm_loadu_ps(Candidates.PositionX + i), OriginX);
+			const auto DeltaY = _mm_sub_ps(_mm_loadu_ps(Candidates.PositionY + i), OriginY);
+			const auto DeltaZ = _mm_sub_ps(PositionZ, OriginZ);
+
+			const auto LocalX = Dot4(DeltaX, DeltaY, DeltaZ, Params.LocalAxisX);
+			const auto RelativeX = Dot4(DeltaX, DeltaY, DeltaZ, Params.DirectionAxisX);
+			const auto RelativeY = Dot4(DeltaX, DeltaY, DeltaZ, Params.DirectionAxisY);
+
+			// Every check builds up a mask of the candidates that are thrown out
+			auto Rejected = _mm_cmpeq_ps(_mm_loadu_ps(Candidates.Eligible + i), Zero);
+
+			if (Params.bRejectBelow)
+			{
+				Rejected = _mm_or_ps(Rejected, _mm_cmplt_ps(PositionZ, MinimumZ));
+			}
+
+			if (Params.bRejectBehind)
+			{
+				Rejected = _mm_or_ps(Rejected, _mm_cmplt_ps(LocalX, Zero));
+			}
+
+			Rejected = _mm_or_ps(Rejected, _mm_cmpgt_ps(LocalX, MaxLocalX));
+
+			if (Params.bRejectOutsideDirection)
+			{
+				Rejected = _mm_or_ps(Rejected, _mm_cmple_ps(RelativeX, Zero));
+			}
+
+			const auto YawDelta = FindDeltaAngleDegrees4(OwnerYaw, _mm_loadu_ps(Candidates.Yaw + i));
+			Rejected = _mm_or_ps(Rejected, _mm_cmpgt_ps(YawDelta, MaxYawDelta));
+
+			const auto PitchDelta = FindDeltaAngleDegrees4(OwnerPitch, _mm_loadu_ps(Candidates.Pitch + i));
+			Rejected = _mm_or_ps(Rejected, _mm_cmpgt_ps(PitchDelta, MaxPitchDelta));
+
+			// Magical formula for deciding best climbable
+			__m128 Rating;
+			if (!Params.bIsForwardInAir)
+			{
+				Rating = _mm_add_ps(_mm_mul_ps(RelativeX, Half), One);
+				Rating = _mm_sub_ps(Rating, _mm_mul_ps(Abs4(RelativeY), Tenth));
+			}
+			else
+			{
+				Rating = _mm_sub_ps(ForwardInAirBase, _mm_mul_ps(Abs4(RelativeX), Tenth));
+				Rating = _mm_sub_ps(Rating, _mm_mul_ps(Abs4(RelativeY), Tenth));
+			}
+
+			_mm_storeu_ps(Candidates.Ratings + i, _mm_andnot_ps(Rejected, Rating));
+		}
+#else
+		ScoreCandidatesScalar(Params, Candidates, Start, End);
+#endif
+	}
+
+	int FindBestCandidate(const float* Ratings, int Num)
+	{
+		int BestIndex = -1;
+		for (int i = 0; i < Num; i++)
+		{
+			if (Ratings[i] > 0.0f && (BestIndex == -1 || Ratings[i] > Ratings[BestIndex]))
+			{
+				BestIndex = i;
+			}
+		}
+		return BestIndex;
+	}
+
+	float FindDeltaAngleDegrees(float A1, float A2)
+	{
+		auto Delta = A2 - A1;
+		if (Delta > 180.0f)
+		{
+			Delta = Delta - 360.0f;
+		}
+		else if (Delta < -180.0f)
+		{
+			Delta = Delta + 360.0f;
+		}
+		return Delta;
+	}
+
+	EDirection GetDirection(const FVec3& OriginLocation, const FVec3& OriginRight, const FVec3& TargetLocation, float DotProductDifference)
+	{
+		auto ToTarget = TargetLocation - OriginLocation;
+		const auto SizeSquared = FVec3::Dot(ToTarget, ToTarget);
+		ToTarget = SizeSquared < 1.e-8f ? FVec3() : ToTarget * (1.0f / std::sqrt(SizeSquared));
+
+		const float Result = FVec3::Dot(ToTarget, OriginRight * -1.0f);
+		if (Result > DotProductDifference)
+		{
+			return EDirection::Left;
+		}
+		else if (Result < -DotProductDifference)
+		{
+			return EDirection::Right;
+		}
+
+		return EDirection::Up;
+	}
+
+	float SampleUniformTable(const float* Samples, int NumSamples, float MinTime, float MaxTime, float Time)
+	{
+		if (NumSamples < 2 || MaxTime <= MinTime)
+		{
+			return NumSamples > 0 ? Samples[0] : 0.0f;
+		}
+
+		const float Position = (Time - MinTime) / (MaxTime - MinTime) * (NumSamples - 1);
+		if (Position <= 0.0f)
+		{
+			return Samples[0];
+		}
+		if (Position >= NumSamples - 1)
+		{
+			return Samples[NumSamples - 1];
+		}
+
+		const int Index = static_cast<int>(Position);
+		const float Alpha = Position - Index;
+		return Samples[Index] + (Samples[Index + 1] - Samples[Index]) * Alpha;
+	}
+
+	FHangingPose GetHangingPose(const FVec3& BaseLocation, const FVec3& Facing, const FVec3& CapsuleUp, float CapsuleHalfHeight,
+	                            float DistanceFromClimbTargetX, float DistanceFromClimbTargetZ)
+	{
+		const auto HangingVerticalLocalPosition = CapsuleUp * (DistanceFromClimbTargetZ + CapsuleHalfHeight);
+		const auto HorizontalDirection = Facing * DistanceFromClimbTargetX;
+
+		FHangingPose Pose;
+		Pose.Location = (BaseLocation - HangingVerticalLocalPosition) + HorizontalDirection;
+
+		// Same as FVector::Rotation
+		Pose.Yaw = std::atan2(Facing.Y, Facing.X) * RadiansToDegrees;
+		Pose.Pitch = std::atan2(Facing.Z, std::sqrt(Facing.X * Facing.X + Facing.Y * Facing.Y)) * RadiansToDegrees;
+		return Pose;
+	}
+}
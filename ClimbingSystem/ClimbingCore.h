@@ -0,0 +1,169 @@
+/* Copyright 2019 Alexandrea Shackelford, Zion Nimchuk, All Rights Reserved.
+ * Unauthorized copying or modification of this file, via any medium is strictly prohibited.
+ */
+#pragma once
+
+/**
+ * The climbing math with no engine dependencies, so that it can be built and benchmarked outside of the editor.
+ * UClimbingComponent converts its actors into these plain types and calls in here for scoring, direction and hanging positions.
+ */
+namespace ClimbingCore
+{
+	struct FVec3
+	{
+		float X = 0.0f;
+		float Y = 0.0f;
+		float Z = 0.0f;
+
+		FVec3() = default;
+		FVec3(float InX, float InY, float InZ) : X(InX), Y(InY), Z(InZ) {}
+
+		FVec3 operator+(const FVec3& Other) const { return {X + Other.X, Y + Other.Y, Z + Other.Z}; }
+		FVec3 operator-(const FVec3& Other) const { return {X - Other.X, Y - Other.Y, Z - Other.Z}; }
+		FVec3 operator*(float Scale) const { return {X * Scale, Y * Scale, Z * Scale}; }
+
+		static float Dot(const FVec3& A, const FVec3& B) { return A.X * B.X + A.Y * B.Y + A.Z * B.Z; }
+	};
+
+	/* Mirrors EClimableDetectionTypeEnum*/
+	enum class EDetectionType
+	{
+		Walking, InAir, ForwardInAir, IsClimbing
+	};
+
+	/* Mirrors EClimbingDirectionEnum*/
+	enum class EDirection
+	{
+		Up, Left, Right
+	};
+
+	/* The tunables and player state that decide which filters FindBestClimbable uses*/
+	struct FScoringInputs
+	{
+		EDetectionType DetectionType = EDetectionType::Walking;
+		bool bIsAttached = false;
+		bool bIsOnGround = false;
+
+		/* Player location, and the axes of its transform. LocalAxisX is pre-divided by the transform's X scale.*/
+		FVec3 Origin;
+		FVec3 LocalAxisX;
+
+		/* Axes of the input direction transform*/
+		FVec3 DirectionAxisX;
+		FVec3 DirectionAxisY;
+
+		float OwnerYaw = 0.0f;
+		float OwnerPitch = 0.0f;
+		float CapsuleHalfHeight = 0.0f;
+
+		float MaxForwardGroundJumpDistance = 0.0f;
+		float MaxForwardThrownDistance = 0.0f;
+		float MaxYawDelta = 0.0f;
+		float MaxPitchDelta = 0.0f;
+	};
+
+	/* Everything the scoring kernel needs, worked out once per query from FScoringInputs*/
+	struct FScoringParams
+	{
+		FVec3 Origin;
+		FVec3 LocalAxisX;
+		FVec3 DirectionAxisX;
+		FVec3 DirectionAxisY;
+
+		float OwnerYaw = 0.0f;
+		float OwnerPitch = 0.0f;
+
+		/* Climbables lower than this get thrown out, when bRejectBelow is set*/
+		float MinimumZ = 0.0f;
+		bool bRejectBelow = false;
+
+		/* Climbables with a negative local X get thrown out, when bRejectBehind is set*/
+		bool bRejectBehind = false;
+
+		/* The furthest a climbable can be in front of the player, in the player's local space*/
+		float MaxLocalX = 0.0f;
+
+		/* Climbables that aren't in the input direction get thrown out, when bRejectOutsideDirection is set*/
+		bool bRejectOutsideDirection = false;
+
+		float MaxYawDelta = 0.0f;
+		float MaxPitchDelta = 0.0f;
+
+		/* Uses the centre-preferring formula from the forward in air check*/
+		bool bIsForwardInAir = false;
+	};
+
+	/**
+	 * Candidates laid out as separate arrays. Every array has to hold a multiple of VectorWidth entries,
+	 * the padding entries need Eligible set to 0.
+	 */
+	struct FCandidateArrays
+	{
+		static constexpr int VectorWidth = 4;
+
+		const float* PositionX = nullptr;
+		const float* PositionY = nullptr;
+		const float* PositionZ = nullptr;
+		const float* Yaw = nullptr;
+		const float* Pitch = nullptr;
+
+		/* 1 when the candidate should be scored, 0 when it was already thrown out*/
+		const float* Eligible = nullptr;
+
+		/* Output, 0 for rejected candidates*/
+		float* Ratings = nullptr;
+	};
+
+	/* Where the player ends up when hanging off a climbable*/
+	struct FHangingPose
+	{
+		FVec3 Location;
+		float Yaw = 0.0f;
+		float Pitch = 0.0f;
+	};
+
+	/* Rounds up to the next multiple of FCandidateArrays::VectorWidth*/
+	inline int PadCandidateCount(int Num)
+	{
+		return (Num + FCandidateArrays::VectorWidth - 1) / FCandidateArrays::VectorWidth * FCandidateArrays::VectorWidth;
+	}
+
+	/* Works out which filters apply for the detection type, the same way FindBestClimbable always has*/
+	FScoringParams MakeScoringParams(const FScoringInputs& Inputs);
+
+	/* Runs the geometric filters and the rating formula on candidates [Start, End), Start and End need to be multiples of the vector width*/
+	void ScoreCandidates(const FScoringParams& Params, const FCandidateArrays& Candidates, int Start, int End);
+
+	/* Same as ScoreCandidates, one candidate at a time. Used as the reference the vector version gets checked against.*/
+	void ScoreCandidatesScalar(const FScoringParams& Params, const FCandidateArrays& Candidates, int Start, int End);
+
+	/* Returns the best rated candidate, ties go to the first one. Returns -1 if nothing had a positive rating.*/
+	int FindBestCandidate(const float* Ratings, int Num);
+
+	/* Same as FMath::FindDeltaAngleDegrees*/
+	float FindDeltaAngleDegrees(float A1, float A2);
+
+	/**
+	 * \brief Works out the animation direction for a jump
+	 * \param OriginRight The right vector of whatever we're jumping from
+	 * \param DotProductDifference The dot product at which the direction switches from left/right to up
+	 */
+	EDirection GetDirection(const FVec3& OriginLocation, const FVec3& OriginRight, const FVec3& TargetLocation, float DotProductDifference);
+
+	/**
+	 * \brief Reads a curve that was sampled at NumSamples evenly spaced times from MinTime to MaxTime, interpolating between samples.
+	 * Times outside the range are clamped to it, the same as the curve itself.
+	 */
+	float SampleUniformTable(const float* Samples, int NumSamples, float MinTime, float MaxTime, float Time);
+
+	/**
+	 * \brief Works out where the player should hang
+	 * \param BaseLocation The point on the climbable that we grab
+	 * \param Facing The direction the player faces while hanging, the climbable's forward for crystals and away from the wall for ledges
+	 * \param CapsuleUp The current up vector of the player's capsule
+	 * \param DistanceFromClimbTargetX How far along Facing the player hangs from BaseLocation
+	 * \param DistanceFromClimbTargetZ How far below BaseLocation the capsule's top is
+	 */
+	FHangingPose GetHangingPose(const FVec3& BaseLocation, const FVec3& Facing, const FVec3& CapsuleUp, float CapsuleHalfHeight,
+		float DistanceFromClimbTargetX, float DistanceFromClimbTargetZ);
+}
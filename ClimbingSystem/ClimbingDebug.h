@@ -0,0 +1,71 @@
+/* Copyright 2019 Alexandrea Shackelford, Zion Nimchuk, All Rights Reserved.
+ * Unauthorized copying or modification of this file, via any medium is strictly prohibited.
+ */
+#pragma once
+
+#include "CoreMinimal.h"
+
+/* Everything the climbing debugger needs is left out of Shipping and Test builds*/
+#define WITH_CLIMBING_DEBUG (!(UE_BUILD_SHIPPING || UE_BUILD_TEST))
+
+#if WITH_CLIMBING_DEBUG
+
+class AActor;
+class AClimbable;
+
+/* Why a candidate wasn't picked, in the order the checks happen*/
+enum class EClimbingDebugRejection : uint8
+{
+	None,
+	NotClimbable,
+	Ledge,
+	Filters,
+	Obstructed,
+	/* Its async obstruction result hadn't come back yet*/
+	Pending,
+	/* A better candidate was picked before this one got checked*/
+	NotReached
+};
+
+struct FClimbingDebugCandidate
+{
+	TWeakObjectPtr<AClimbable> Climbable;
+	FVector Location = FVector::ZeroVector;
+	float Rating = 0.0f;
+	EClimbingDebugRejection Rejection = EClimbingDebugRejection::NotReached;
+
+	/* What was in the way, unless the result came from a cache*/
+	TWeakObjectPtr<AActor> ObstructedBy;
+};
+
+/**
+ * What the climbing component did on its last detection and FindBestClimbable, kept by the component only while the Gameplay Debugger
+ * is showing it, so none of this is worked out otherwise.
+ */
+struct FClimbingDebugSnapshot
+{
+	/* The frame the debugger last asked for this, it's thrown away once it stops asking*/
+	uint64 LastRequestFrame = 0;
+
+	/* Detection, from the last tick*/
+	const TCHAR* DetectionSource = TEXT("");
+	bool bDetectedWithCapsule = false;
+	bool bDetectedAny = false;
+	FVector DetectionCenter = FVector::ZeroVector;
+	float DetectionRadius = 0.0f;
+	float DetectionHalfHeight = 0.0f;
+
+	/* The last FindBestClimbable*/
+	uint64 QueryFrame = 0;
+	FVector QueryOrigin = FVector::ZeroVector;
+	FVector QueryDirection = FVector::ZeroVector;
+	TArray<FClimbingDebugCandidate> Candidates;
+	TWeakObjectPtr<AClimbable> Picked;
+	FTransform PickedHangingTransform;
+	uint32 NumObstructionQueries = 0;
+
+	/* Set by the obstruction checks for the candidate loop to pick up*/
+	TWeakObjectPtr<AActor> LastObstructedBy;
+};
+
+#endif
@@ -0,0 +1,139 @@
+/* Copyright 2019 Alexandrea Shackelford, Zion Nimchuk, All Rights Reserved.
+ * Unauthorized copying or modification of this file, via any medium is strictly prohibited.
+ */
+
+#include "ClimbingGraph.h"
+#include "World/Climbable.h"
+#include "World/SplineLedge.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/Character.h"
+#include "Components/CapsuleComponent.h"
+#include "ClimbingComponent.h"
+#include "ClimbingScoring.h"
+#include "ClimbingCore.h"
+
+AClimbingGraph::AClimbingGraph()
+{
+	PrimaryActorTick.bCanEverTick = false;
+	SetRootComponent(CreateDefaultSubobject<USceneComponent>(TEXT("Root")));
+}
+
+#if WITH_EDITOR
+void AClimbingGraph::Bake()
+{
+	auto World = GetWorld();
+	auto PlayerDefaults = PlayerClass != nullptr ? PlayerClass.GetDefaultObject() : nullptr;
+	auto ClimbingDefaults = PlayerDefaults != nullptr ? PlayerDefaults->FindComponentByClass<UClimbingComponent>() : nullptr;
+	if (World == nullptr || ClimbingDefaults == nullptr)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s needs a PlayerClass with a climbing component to bake"), *GetName())
+		return;
+	}
+
+	const auto CapsuleRadius = PlayerDefaults->GetCapsuleComponent()->GetScaledCapsuleRadius();
+	const auto CapsuleHalfHeight = PlayerDefaults->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+
+	Modify();
+	Nodes.Reset();
+	NodeLocations.Reset();
+	NodeRotations.Reset();
+	NeighbourOffsets.Reset();
+	Neighbours.Reset();
+	DetectionRadius = ClimbingDefaults->ClimbingDetectionRadius;
+
+	// Moving climbables are left out, they're always picked up at runtime
+	for (TActorIterator<AClimbable> It(World); It; ++It)
+	{
+		if (It->GetLevel() == GetLevel() && !It->bIsMoving)
+		{
+			Nodes.Add(*It);
+			NodeLocations.Add(It->GetActorLocation());
+			NodeRotations.Add(It->GetActorQuat());
+		}
+	}
+
+	FClimbReachabilitySettings Settings;
+	Settings.CapsuleHalfHeight = CapsuleHalfHeight;
+	Settings.DistanceFromClimbTarget = ClimbingDefaults->DistanceFromClimbTarget;
+	Settings.MaxRotationDelta = ClimbingDefaults->MaxYRotation;
+
+	TArray<FBox> Bounds;
+	TArray<bool> IsLedge;
+	TArray<bool> IsObstructed;
+	TArray<FOverlapResult> Overlaps;
+
+	for (auto Climbable : Nodes)
+	{
+		FVector Origin, Extent;
+		Climbable->GetActorBounds(/*bOnlyCollidingComponents: */true, Origin, Extent);
+		Bounds.Add(FBox::BuildAABB(Origin, Extent));
+
+		const bool bIsLedge = Cast<ASplineLedge>(Climbable) != nullptr;
+		IsLedge.Add(bIsLedge);
+
+		// Ledges never get an obstruction check, and where we'd hang depends on where we come from anyway
+		bool bIsBlocked = false;
+		if (!bIsLedge)
+		{
+			// Same as GetHangingPosition, with the capsule upright like it is when we grab on
+			const auto Pose = ClimbingCore::GetHangingPose(ToClimbingCore(Climbable->GetActorLocation()),
+				ToClimbingCore(Climbable->GetActorForwardVector()), ToClimbingCore(FVector::UpVector), CapsuleHalfHeight,
+				Settings.DistanceFromClimbTarget.X, Settings.DistanceFromClimbTarget.Z);
+
+			Overlaps.Reset();
+			World->OverlapMultiByObjectType(Overlaps, FromClimbingCore(Pose.Location), FRotator(Pose.Pitch, Pose.Yaw, 0.0f).Quaternion(),
+				UClimbingComponent::GetObstructionObjectParams(), FCollisionShape::MakeCapsule(CapsuleRadius, CapsuleHalfHeight));
+
+			for (const auto& Overlap : Overlaps)
+			{
+				if (UClimbingComponent::DoesOverlapBlockClimbing(Overlap))
+				{
+					bIsBlocked = true;
+					break;
+				}
+			}
+		}
+		IsObstructed.Add(bIsBlocked);
+	}
+
+	FClimbableScoringBatch ScoringBatch;
+	TArray<AClimbable*> Candidates;
+	TArray<int32> CandidateNodes;
+	TArray<int32> Reachable;
+	const auto RadiusSquared = FMath::Square(DetectionRadius);
+
+	for (int32 i = 0; i < Nodes.Num(); i++)
+	{
+		NeighbourOffsets.Add(Neighbours.Num());
+
+		// We never hang off a ledge, we mantle straight up it
+		if (IsLedge[i])
+		{
+			continue;
+		}
+
+		// Detection is centred on the climbable we're attached to
+		const auto Center = Nodes[i]->GetActorLocation();
+		Candidates.Reset();
+		CandidateNodes.Reset();
+		for (int32 j = 0; j < Nodes.Num(); j++)
+		{
+			if (j != i && !IsObstructed[j] && Bounds[j].ComputeSquaredDistanceToPoint(Center) <= RadiusSquared)
+			{
+				Candidates.Add(Nodes[j]);
+				CandidateNodes.Add(j);
+			}
+		}
+
+		ClimbingScoring::FilterReachable(Nodes[i], Settings, Candidates, ScoringBatch, Reachable);
+		for (auto Candidate : Reachable)
+		{
+			Neighbours.Add(CandidateNodes[Candidate]);
+		}
+	}
+	NeighbourOffsets.Add(Neighbours.Num());
+
+	UE_LOG(LogTemp, Log, TEXT("%s baked %d climbables with %d connections"), *GetName(), Nodes.Num(), Neighbours.Num())
+}
+#endif
@@ -0,0 +1,76 @@
+/* Copyright 2019 Alexandrea Shackelford, Zion Nimchuk, All Rights Reserved.
+ * Unauthorized copying or modification of this file, via any medium is strictly prohibited.
+ */
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "ClimbingGraph.generated.h"
+
+class AClimbable;
+class ACharacter;
+
+/**
+ * Which climbables can be reached from each static climbable in a level, baked in the editor. Place one in every level that has
+ * climbables, and hit Bake after moving any of them. While attached to a static climbable, the climbing component takes its
+ * candidates from here instead of querying the climbable index, and skips the obstruction checks since the bake already did them.
+ * Moving climbables are never baked, they're always found at runtime, and so are climbables in other levels that are in reach of a
+ * climbable near a level seam.
+ */
+UCLASS(NotBlueprintable)
+class THEELDER_API AClimbingGraph : public AActor
+{
+	GENERATED_BODY()
+
+public:
+
+	AClimbingGraph();
+
+#if WITH_EDITOR
+	/* Rebuilds the graph from the static climbables in this level, with the climbing tunables and capsule of PlayerClass*/
+	UFUNCTION(CallInEditor, Category = "Climbing Graph")
+	void Bake();
+#endif
+
+	/* The character the graph is baked for, its climbing component's tunables and its capsule are what decide what's reachable*/
+	UPROPERTY(EditAnywhere, Category = "Climbing Graph")
+	TSubclassOf<ACharacter> PlayerClass;
+
+	int32 GetNumNodes() const { return Nodes.Num(); }
+
+	AClimbable* GetNode(int32 Node) const { return Nodes[Node]; }
+
+	/* Where the climbable was when the graph was baked, if it's anywhere else now the graph is out of date*/
+	const FVector& GetNodeLocation(int32 Node) const { return NodeLocations[Node]; }
+	const FQuat& GetNodeRotation(int32 Node) const { return NodeRotations[Node]; }
+
+	/* The nodes that can be reached from Node*/
+	TArrayView<const int32> GetNeighbours(int32 Node) const
+	{
+		return TArrayView<const int32>(Neighbours.GetData() + NeighbourOffsets[Node], NeighbourOffsets[Node + 1] - NeighbourOffsets[Node]);
+	}
+
+	/* The detection radius used for the bake, the graph can't answer queries with any other radius*/
+	float GetDetectionRadius() const { return DetectionRadius; }
+
+private:
+
+	UPROPERTY(VisibleAnywhere, Category = "Climbing Graph")
+	TArray<AClimbable*> Nodes;
+
+	UPROPERTY()
+	TArray<FVector> NodeLocations;
+
+	UPROPERTY()
+	TArray<FQuat> NodeRotations;
+
+	/* Node i's neighbours are Neighbours[NeighbourOffsets[i]] up to Neighbours[NeighbourOffsets[i + 1]], so there's one more offset than nodes*/
+	UPROPERTY()
+	TArray<int32> NeighbourOffsets;
+
+	UPROPERTY()
+	TArray<int32> Neighbours;
+
+	UPROPERTY(VisibleAnywhere, Category = "Climbing Graph")
+	float DetectionRadius = 0.0f;
+};
@@ -0,0 +1,520 @@
+/* Copyright 2019 Alexandrea Shackelford, Zion Nimchuk, All Rights Reserved.
+ * Unauthorized copying or modification of this file, via any medium is strictly prohibited.
+ */
+
+#include "ClimbingPerf.h"
+#include "ClimbingComponent.h"
+#include "World/Climbable.h"
+#include "World/SplineLedge.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "Containers/Ticker.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/ThreadSafeCounter64.h"
+#include "Misc/Parse.h"
+#include "ProfilingDebugging/MiscTrace.h"
+#include "Kismet/GameplayStatics.h"
+
+static TAutoConsoleVariable<float> CVarClimbingPerfBudgetP95(
+	TEXT("Climbing.Perf.BudgetP95"),
+	2.0f,
+	TEXT("Milliseconds every climbing component together can take on 95% of the frames in a Climbing.Perf capture."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarClimbingPerfBudgetP99(
+	TEXT("Climbing.Perf.BudgetP99"),
+	4.0f,
+	TEXT("Milliseconds every climbing component together can take on 99% of the frames in a Climbing.Perf capture."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarClimbingPerfMaxAllocations(
+	TEXT("Climbing.Perf.MaxAllocations"),
+	0,
+	TEXT("Heap allocations each phase (the tick, climb presses, detection, picking a climbable, ...) can make over a Climbing.Perf capture, ")
+	TEXT("once the warm up frames are over."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarClimbingPerfWarmupFrames(
+	TEXT("Climbing.Perf.WarmupFrames"),
+	60,
+	TEXT("Frames at the start of a Climbing.Perf capture whose allocations don't count, while the caches and buffers fill up."),
+	ECVF_Default);
+
+FClimbingPerfCapture* FClimbingPerfCapture::Active = nullptr;
+
+namespace
+{
+	const TCHAR* const PhaseNames[] = {
+		TEXT("Tick"), TEXT("ClimbPress"), TEXT("DetectClimbables"), TEXT("FindBestClimbable"), TEXT("UpdateClimbRoute"), TEXT("UpdateMovement")
+	};
+	static_assert(UE_ARRAY_COUNT(PhaseNames) == static_cast<int32>(EClimbingPerfPhase::Num), "Every phase needs a name");
+
+	/* Set on whichever thread is inside a FClimbingPerfParallelScope*/
+	thread_local bool bIsInParallelScope = false;
+
+	/**
+	 * Passes everything through to the allocator it replaced, counting the allocations made on the game thread and in climbing work
+	 * handed to the other threads. Installed by the first capture and never taken out again, anything allocated through it might still
+	 * be freed through it.
+	 */
+	class FClimbingAllocationCounter final : public FMalloc
+	{
+	public:
+
+		explicit FClimbingAllocationCounter(FMalloc* InInner)
+			: Inner(InInner)
+		{
+		}
+
+		/* Only ever written from the game thread, so it doesn't need to be atomic*/
+		uint64 GameThreadAllocations = 0;
+
+		/* Everything allocated inside a FClimbingPerfParallelScope off the game thread, which can be on several threads at once*/
+		FThreadSafeCounter64 ParallelScopeAllocations;
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->Malloc(Count, Alignment);
+		}
+
+		virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->TryMalloc(Count, Alignment);
+		}
+
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			// Shrinking to nothing is a free, anything else might have to move the block
+			if (Count > 0)
+			{
+				CountAllocation();
+			}
+			return Inner->Realloc(Original, Count, Alignment);
+		}
+
+		virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			if (Count > 0)
+			{
+				CountAllocation();
+			}
+			return Inner->TryRealloc(Original, Count, Alignment);
+		}
+
+		virtual void Free(void* Original) override { Inner->Free(Original); }
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+		virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+		virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override { Inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+		virtual void InitializeStatsMetadata() override { Inner->InitializeStatsMetadata(); }
+		virtual void UpdateStats() override { Inner->UpdateStats(); }
+		virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { Inner->GetAllocatorStats(OutStats); }
+		virtual void DumpAllocatorStats(FOutputDevice& Ar) override { Inner->DumpAllocatorStats(Ar); }
+		virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+		virtual bool ValidateHeap() override { return Inner->ValidateHeap(); }
+		virtual const TCHAR* GetDescriptiveName() override { return Inner->GetDescriptiveName(); }
+
+	private:
+
+		FMalloc* Inner;
+
+		void CountAllocation()
+		{
+			if (IsInGameThread())
+			{
+				GameThreadAllocations++;
+			}
+			else if (bIsInParallelScope)
+			{
+				ParallelScopeAllocations.Increment();
+			}
+		}
+	};
+
+	FClimbingAllocationCounter* AllocationCounter = nullptr;
+
+	/* Times has to be sorted*/
+	double GetPercentile(const TArray<double>& Times, double Percentile)
+	{
+		return Times[FMath::Min(FMath::FloorToInt(Times.Num() * Percentile), Times.Num() - 1)];
+	}
+
+	/* The climbers spawned by Climbing.Perf.Spawn, and the button presses that keep them busy*/
+	struct FClimbingPerfDriver
+	{
+		TArray<TWeakObjectPtr<APawn>> Climbers;
+		TArray<float> NextPress;
+		TArray<TWeakObjectPtr<AActor>> SpawnedActors;
+		float PressInterval = 0.25f;
+		float Time = 0.0f;
+
+		/* Frames left in a Climbing.Perf.Run, 0 when there isn't one*/
+		int32 FramesLeft = 0;
+		bool bExitWhenDone = false;
+
+		FDelegateHandle TickerHandle;
+
+		bool Tick(float DeltaTime)
+		{
+			Time += DeltaTime;
+			bool bHasClimbers = false;
+			for (int32 i = 0; i < Climbers.Num(); i++)
+			{
+				auto Climber = Climbers[i].Get();
+				auto ClimbingComponent = Climber != nullptr ? Climber->FindComponentByClass<UClimbingComponent>() : nullptr;
+				bHasClimbers |= ClimbingComponent != nullptr;
+				if (ClimbingComponent == nullptr || Time < NextPress[i])
+				{
+					continue;
+				}
+
+				// The same thing a button press does, without any input the climber just goes up
+				NextPress[i] = Time + PressInterval;
+				if (!ClimbingComponent->IsMovingToNewClimbable())
+				{
+					ClimbingComponent->ForceInitClimb();
+				}
+			}
+
+			if (FramesLeft > 0 && --FramesLeft == 0)
+			{
+				const bool bPassed = FClimbingPerfCapture::Stop();
+				if (bExitWhenDone)
+				{
+					FPlatformMisc::RequestExitWithStatus(/*Force: */false, bPassed ? 0 : 1);
+				}
+			}
+
+			// Nothing left to press for or count down, so stop ticking until Spawn or Run needs us again
+			if (!bHasClimbers && FramesLeft == 0)
+			{
+				TickerHandle.Reset();
+				return false;
+			}
+			return true;
+		}
+
+		void Reset()
+		{
+			for (const auto& Actor : SpawnedActors)
+			{
+				if (Actor.IsValid())
+				{
+					Actor->Destroy();
+				}
+			}
+			SpawnedActors.Reset();
+			Climbers.Reset();
+			NextPress.Reset();
+
+			if (FramesLeft == 0)
+			{
+				StopTicking();
+			}
+		}
+
+		void EnsureTicking()
+		{
+			if (!TickerHandle.IsValid())
+			{
+				TickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FClimbingPerfDriver::Tick));
+			}
+		}
+
+		void StopTicking()
+		{
+			if (TickerHandle.IsValid())
+			{
+				FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+				TickerHandle.Reset();
+			}
+		}
+	};
+
+	FClimbingPerfDriver PerfDriver;
+
+	/* Spawns Rows x Columns climbables on a wall in front of the player, a row of ledges along its top, and climbers at its foot*/
+	void SpawnClimbingLoad(UWorld* World, const FString& Params)
+	{
+		auto Player = UGameplayStatics::GetPlayerPawn(World, 0);
+		if (Player == nullptr)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Climbing.Perf.Spawn needs a player to copy the climbers from"));
+			return;
+		}
+
+		int32 NumClimbables = 1000;
+		int32 NumLedges = 100;
+		int32 NumClimbers = 10;
+		float Spacing = 300.0f;
+		FString ClimbablePath;
+		FString LedgePath;
+		FParse::Value(*Params, TEXT("Climbables="), NumClimbables);
+		FParse::Value(*Params, TEXT("Ledges="), NumLedges);
+		FParse::Value(*Params, TEXT("Climbers="), NumClimbers);
+		FParse::Value(*Params, TEXT("Spacing="), Spacing);
+		FParse::Value(*Params, TEXT("Interval="), PerfDriver.PressInterval);
+		FParse::Value(*Params, TEXT("ClimbableClass="), ClimbablePath);
+		FParse::Value(*Params, TEXT("LedgeClass="), LedgePath);
+
+		// Blueprints give the climbables their collision, the native classes are only there so it runs without any content
+		UClass* ClimbableClass = ClimbablePath.IsEmpty() ? AClimbable::StaticClass() : LoadClass<AClimbable>(nullptr, *ClimbablePath);
+		UClass* LedgeClass = LedgePath.IsEmpty() ? ASplineLedge::StaticClass() : LoadClass<ASplineLedge>(nullptr, *LedgePath);
+		if (ClimbableClass == nullptr || LedgeClass == nullptr)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Climbing.Perf.Spawn couldn't load %s"), ClimbableClass == nullptr ? *ClimbablePath : *LedgePath);
+			return;
+		}
+
+		PerfDriver.Reset();
+
+		const auto Facing = FRotator(0.0f, Player->GetActorRotation().Yaw, 0.0f);
+		const auto Forward = Facing.Vector();
+		const auto Right = FRotationMatrix(Facing).GetUnitAxis(EAxis::Y);
+		const auto Columns = FMath::Max(FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumClimbables))), 1);
+		const auto WallOrigin = Player->GetActorLocation() + Forward * 500.0f - Right * (Columns * Spacing * 0.5f);
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		// Climbables face the same way as the climbers, which is the way they hang off them
+		for (int32 i = 0; i < NumClimbables; i++)
+		{
+			const auto Location = WallOrigin + Right * ((i % Columns) * Spacing) + FVector::UpVector * ((i / Columns) * Spacing);
+			PerfDriver.SpawnedActors.Add(World->SpawnActor<AActor>(ClimbableClass, Location, Facing, SpawnParams));
+		}
+
+		const auto WallTop = WallOrigin + FVector::UpVector * (FMath::DivideAndRoundUp(NumClimbables, Columns) * Spacing);
+		for (int32 i = 0; i < NumLedges; i++)
+		{
+			const auto Location = WallTop + Right * (i * Columns * Spacing / FMath::Max(NumLedges, 1));
+			PerfDriver.SpawnedActors.Add(World->SpawnActor<AActor>(LedgeClass, Location, Facing, SpawnParams));
+		}
+
+		for (int32 i = 0; i < NumClimbers; i++)
+		{
+			const auto Location = WallOrigin - Forward * 200.0f + Right * ((i + 0.5f) * Columns * Spacing / FMath::Max(NumClimbers, 1));
+			auto Climber = World->SpawnActor<APawn>(Player->GetClass(), Location, Facing, SpawnParams);
+			if (Climber == nullptr)
+			{
+				continue;
+			}
+
+			// Without a controller they'd only be played back like someone else's character
+			Climber->SpawnDefaultController();
+			PerfDriver.SpawnedActors.Add(Climber);
+			PerfDriver.Climbers.Add(Climber);
+
+			// Spread the presses out, everyone pressing on the same frame isn't what we're trying to measure
+			PerfDriver.NextPress.Add(PerfDriver.Time + PerfDriver.PressInterval * i / FMath::Max(NumClimbers, 1));
+		}
+
+		PerfDriver.EnsureTicking();
+
+		UE_LOG(LogTemp, Log, TEXT("Climbing.Perf.Spawn: %d climbables, %d ledges, %d climbers"), NumClimbables, NumLedges, PerfDriver.Climbers.Num());
+	}
+}
+
+void FClimbingPerfCapture::Start()
+{
+	if (Active != nullptr)
+	{
+		return;
+	}
+
+	if (AllocationCounter == nullptr)
+	{
+		AllocationCounter = new FClimbingAllocationCounter(GMalloc);
+		GMalloc = AllocationCounter;
+	}
+
+	Active = new FClimbingPerfCapture();
+	Active->StartTime = FPlatformTime::Seconds();
+	TRACE_BOOKMARK(TEXT("Climbing.Perf.Start"));
+}
+
+bool FClimbingPerfCapture::Stop()
+{
+	if (Active == nullptr)
+	{
+		return true;
+	}
+
+	TRACE_BOOKMARK(TEXT("Climbing.Perf.Stop"));
+
+	auto Capture = Active;
+	Active = nullptr;
+	const bool bPassed = Capture->Report();
+	delete Capture;
+	return bPassed;
+}
+
+FClimbingPerfCapture* FClimbingPerfCapture::Get()
+{
+	return bIsInParallelScope ? nullptr : Active;
+}
+
+uint64 FClimbingPerfCapture::GetAllocations()
+{
+	return AllocationCounter != nullptr
+		? AllocationCounter->GameThreadAllocations + static_cast<uint64>(AllocationCounter->ParallelScopeAllocations.GetValue())
+		: 0;
+}
+
+FClimbingPerfParallelScope::FClimbingPerfParallelScope()
+	: bWasInParallelScope(bIsInParallelScope)
+{
+	bIsInParallelScope = true;
+}
+
+FClimbingPerfParallelScope::~FClimbingPerfParallelScope()
+{
+	bIsInParallelScope = bWasInParallelScope;
+}
+
+void FClimbingPerfCapture::AddSample(EClimbingPerfPhase Phase, uint64 Cycles, uint64 Allocations)
+{
+	const auto Milliseconds = FPlatformTime::ToMilliseconds64(Cycles);
+	PhaseTimes[static_cast<int32>(Phase)].Add(Milliseconds);
+	PhaseAllocations[static_cast<int32>(Phase)] += Allocations;
+
+	// The first frames fill up the caches and buffers, after that nothing should be allocating at all. Presses come from input, outside
+	// the tick, so every phase is held to this and not just the tick.
+	if (Allocations > 0 && FrameTimes.Num() >= CVarClimbingPerfWarmupFrames.GetValueOnGameThread())
+	{
+		SteadyPhaseAllocations[static_cast<int32>(Phase)] += Allocations;
+		SteadyCallsThatAllocated[static_cast<int32>(Phase)]++;
+	}
+
+	// Every climber's tick is added up for the frame, that's what the budgets are for
+	if (Phase == EClimbingPerfPhase::Tick)
+	{
+		if (CurrentFrame != GFrameCounter)
+		{
+			if (CurrentFrame != 0)
+			{
+				FrameTimes.Add(CurrentFrameTime);
+			}
+			CurrentFrame = GFrameCounter;
+			CurrentFrameTime = 0.0;
+		}
+		CurrentFrameTime += Milliseconds;
+	}
+}
+
+bool FClimbingPerfCapture::Report()
+{
+	if (CurrentFrame != 0)
+	{
+		FrameTimes.Add(CurrentFrameTime);
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Climbing.Perf: %d frames over %.1fs"), FrameTimes.Num(), FPlatformTime::Seconds() - StartTime);
+
+	for (int32 i = 0; i < static_cast<int32>(EClimbingPerfPhase::Num); i++)
+	{
+		auto& Times = PhaseTimes[i];
+		if (Times.Num() == 0)
+		{
+			continue;
+		}
+		Times.Sort();
+
+		UE_LOG(LogTemp, Log, TEXT("Climbing.Perf: %-18s %8d calls, %.4fms median, %.4fms 95th, %.4fms 99th, %.4fms worst, %llu allocations"),
+			PhaseNames[i], Times.Num(), GetPercentile(Times, 0.5), GetPercentile(Times, 0.95), GetPercentile(Times, 0.99), Times.Last(),
+			PhaseAllocations[i]);
+	}
+
+	if (FrameTimes.Num() == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Climbing.Perf: no climbing component ticked during the capture"));
+		return false;
+	}
+	FrameTimes.Sort();
+
+	const auto P95 = GetPercentile(FrameTimes, 0.95);
+	const auto P99 = GetPercentile(FrameTimes, 0.99);
+	const auto BudgetP95 = CVarClimbingPerfBudgetP95.GetValueOnGameThread();
+	const auto BudgetP99 = CVarClimbingPerfBudgetP99.GetValueOnGameThread();
+	const bool bInBudget = P95 <= BudgetP95 && P99 <= BudgetP99;
+
+	if (bInBudget)
+	{
+		UE_LOG(LogTemp, Log, TEXT("Climbing.Perf: per frame %.3fms 95th (budget %.3fms), %.3fms 99th (budget %.3fms)"),
+			P95, BudgetP95, P99, BudgetP99);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("Climbing.Perf: over budget, per frame %.3fms 95th (budget %.3fms), %.3fms 99th (budget %.3fms)"),
+			P95, BudgetP95, P99, BudgetP99);
+	}
+
+	// Phases nest, so each one is held to the budget on its own instead of adding them up
+	const auto MaxAllocations = static_cast<uint64>(FMath::Max(CVarClimbingPerfMaxAllocations.GetValueOnGameThread(), 0));
+	bool bAllocationsInBudget = true;
+	for (int32 i = 0; i < static_cast<int32>(EClimbingPerfPhase::Num); i++)
+	{
+		if (SteadyPhaseAllocations[i] > MaxAllocations)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Climbing.Perf: %s made %llu heap allocations over %d calls after warming up (budget %llu)"),
+				PhaseNames[i], SteadyPhaseAllocations[i], SteadyCallsThatAllocated[i], MaxAllocations);
+			bAllocationsInBudget = false;
+		}
+	}
+
+	if (bAllocationsInBudget)
+	{
+		UE_LOG(LogTemp, Log, TEXT("Climbing.Perf: no phase went over %llu heap allocations after warming up"), MaxAllocations);
+	}
+
+	return bInBudget && bAllocationsInBudget;
+}
+
+static FAutoConsoleCommandWithWorldAndArgs ClimbingPerfSpawnCommand(
+	TEXT("Climbing.Perf.Spawn"),
+	TEXT("Spawns a wall of climbables and ledges in front of the player, with copies of the player pressing climb on it. ")
+	TEXT("Climbables=1000 Ledges=100 Climbers=10 Spacing=300 Interval=0.25, ClimbableClass= and LedgeClass= take Blueprint class paths."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		SpawnClimbingLoad(World, FString::Join(Args, TEXT(" ")));
+	}));
+
+static FAutoConsoleCommand ClimbingPerfClearCommand(
+	TEXT("Climbing.Perf.Clear"),
+	TEXT("Destroys everything Climbing.Perf.Spawn spawned."),
+	FConsoleCommandDelegate::CreateLambda([]
+	{
+		PerfDriver.Reset();
+	}));
+
+static FAutoConsoleCommand ClimbingPerfStartCommand(
+	TEXT("Climbing.Perf.Start"),
+	TEXT("Starts timing every climbing component, phase by phase."),
+	FConsoleCommandDelegate::CreateLambda([]
+	{
+		FClimbingPerfCapture::Start();
+	}));
+
+static FAutoConsoleCommand ClimbingPerfStopCommand(
+	TEXT("Climbing.Perf.Stop"),
+	TEXT("Stops timing and logs the percentiles, with an error if Climbing.Perf.BudgetP95, Climbing.Perf.BudgetP99 or Climbing.Perf.MaxAllocations was gone over."),
+	FConsoleCommandDelegate::CreateLambda([]
+	{
+		FClimbingPerfCapture::Stop();
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs ClimbingPerfRunCommand(
+	TEXT("Climbing.Perf.Run"),
+	TEXT("Times the next <Frames> frames (600 by default) like Climbing.Perf.Start and Stop. With Exit, quits afterwards with 1 if it went over budget."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		// "Climbing.Perf.Run Exit" is the default number of frames, not 0 of them
+		PerfDriver.FramesLeft = Args.Num() > 0 && Args[0].IsNumeric() ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 600;
+		PerfDriver.bExitWhenDone = Args.ContainsByPredicate([](const FString& Arg) { return Arg.Equals(TEXT("Exit"), ESearchCase::IgnoreCase); });
+		PerfDriver.EnsureTicking();
+		FClimbingPerfCapture::Start();
+	}));
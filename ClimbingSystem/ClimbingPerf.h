@@ -0,0 +1,113 @@
+/* Copyright 2019 Alexandrea Shackelford, Zion Nimchuk, All Rights Reserved.
+ * Unauthorized copying or modification of this file, via any medium is strictly prohibited.
+ */
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformTime.h"
+
+/* The parts of UClimbingComponent that get timed separately, ClimbPress is ForceInitClimb, which doesn't go through the tick*/
+enum class EClimbingPerfPhase : uint8
+{
+	Tick,
+	ClimbPress,
+	DetectClimbables,
+	FindBestClimbable,
+	UpdateClimbRoute,
+	UpdateMovement,
+	Num
+};
+
+/**
+ * Times every climbing component in the world phase by phase while it's running, then logs the percentiles and checks the frame's total
+ * climbing time against Climbing.Perf.BudgetP95 and Climbing.Perf.BudgetP99. Load is made with Climbing.Perf.Spawn, and a whole run
+ * is done headless on the Linux build machines by ClimbingBenchmark/RunClimbingPerfCapture.sh (.bat on Windows), which runs
+ *
+ *     UnrealEditor-Cmd TheElder.uproject <Map> -game -nullrhi -unattended -trace=cpu,bookmark
+ *         -ExecCmds="Climbing.Perf.Spawn Climbables=2000 Ledges=200 Climbers=20, Climbing.Perf.Run 1800 Exit"
+ *
+ * and exits with 1 if either budget was blown, or if any of the phases made more than Climbing.Perf.MaxAllocations heap
+ * allocations once Climbing.Perf.WarmupFrames frames have gone by. The climbing stats are Insights scopes as well, and the capture is
+ * bookmarked in the trace, so traces from before and after a change line up.
+ */
+class THEELDER_API FClimbingPerfCapture
+{
+public:
+
+	/* Nothing is timed unless this is set, so the scopes only cost a pointer check otherwise. It's never set inside a
+	 * FClimbingPerfParallelScope, since samples can only be added from one thread.*/
+	static FClimbingPerfCapture* Get();
+
+	static void Start();
+
+	/* Logs the results, returns false if the frames went over budget*/
+	static bool Stop();
+
+	void AddSample(EClimbingPerfPhase Phase, uint64 Cycles, uint64 Allocations);
+
+	/* Heap allocations made on the game thread, or inside a FClimbingPerfParallelScope on any other thread, since the first capture.
+	 * The allocator is only counted from then on.*/
+	static uint64 GetAllocations();
+
+private:
+
+	static FClimbingPerfCapture* Active;
+
+	/* Milliseconds for each call, per phase*/
+	TArray<double> PhaseTimes[static_cast<int32>(EClimbingPerfPhase::Num)];
+
+	/* Milliseconds every climber's tick took together, per frame*/
+	TArray<double> FrameTimes;
+
+	/* Heap allocations for each phase, over the whole capture and once the warm up frames are over*/
+	uint64 PhaseAllocations[static_cast<int32>(EClimbingPerfPhase::Num)] = {};
+	uint64 SteadyPhaseAllocations[static_cast<int32>(EClimbingPerfPhase::Num)] = {};
+	int32 SteadyCallsThatAllocated[static_cast<int32>(EClimbingPerfPhase::Num)] = {};
+
+	uint64 CurrentFrame = 0;
+	double CurrentFrameTime = 0.0;
+	double StartTime = 0.0;
+
+	bool Report();
+};
+
+/* Times the rest of the scope into the running capture, if there is one*/
+struct FClimbingPerfScope
+{
+	explicit FClimbingPerfScope(EClimbingPerfPhase InPhase)
+		: Capture(FClimbingPerfCapture::Get()), Phase(InPhase), StartCycles(Capture != nullptr ? FPlatformTime::Cycles64() : 0),
+		StartAllocations(Capture != nullptr ? FClimbingPerfCapture::GetAllocations() : 0)
+	{
+	}
+
+	~FClimbingPerfScope()
+	{
+		if (Capture != nullptr)
+		{
+			Capture->AddSample(Phase, FPlatformTime::Cycles64() - StartCycles, FClimbingPerfCapture::GetAllocations() - StartAllocations);
+		}
+	}
+
+private:
+
+	FClimbingPerfCapture* Capture;
+	EClimbingPerfPhase Phase;
+	uint64 StartCycles;
+	uint64 StartAllocations;
+};
+
+/**
+ * Marks climbing work handed to the worker threads, like the batched tick's ComputeTicks. Nothing inside it is timed on its own, but its
+ * heap allocations count towards the scope that's running on the game thread, so the batch as a whole is still held to the budget.
+ */
+struct THEELDER_API FClimbingPerfParallelScope
+{
+	FClimbingPerfParallelScope();
+	~FClimbingPerfParallelScope();
+
+private:
+
+	bool bWasInParallelScope;
+};
+
+#define CLIMBING_PERF_SCOPE(Phase) FClimbingPerfScope PREPROCESSOR_JOIN(ClimbingPerfScope, __LINE__)(EClimbingPerfPhase::Phase)
@@ -0,0 +1,313 @@
+/* Copyright 2019 Alexandrea Shackelford, Zion Nimchuk, All Rights Reserved.
+ * Unauthorized copying or modification of this file, via any medium is strictly prohibited.
+ */
+
+#include "ClimbingRecorder.h"
+#include "ClimbingComponent.h"
+#include "World/Climbable.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/Package.h"
+#include "Serialization/MemoryReader.h"
+#include "Kismet/GameplayStatics.h"
+
+namespace
+{
+	/* Fixed part of the file, so that Load can tell if it's something it can read before going any further*/
+	struct FClimbingRecordingHeader
+	{
+		uint32 Magic = FClimbingRecording::Magic;
+		uint32 Version = FClimbingRecording::Version;
+		FString MapName;
+
+		friend FArchive& operator<<(FArchive& Ar, FClimbingRecordingHeader& Header)
+		{
+			return Ar << Header.Magic << Header.Version << Header.MapName;
+		}
+	};
+
+	UClimbingComponent* FindPlayerClimbingComponent(UWorld* World)
+	{
+		auto Pawn = UGameplayStatics::GetPlayerPawn(World, 0);
+		auto ClimbingComponent = Pawn != nullptr ? Pawn->FindComponentByClass<UClimbingComponent>() : nullptr;
+		if (ClimbingComponent == nullptr)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("The player doesn't have a climbing component to record or replay"));
+		}
+		return ClimbingComponent;
+	}
+
+	FString GetRecordingFilename(const TArray<FString>& Args)
+	{
+		if (Args.Num() > 0)
+		{
+			return Args[0];
+		}
+		return FPaths::ProjectSavedDir() / TEXT("Climbing") / FString::Printf(TEXT("Climbing-%s.climbrec"), *FDateTime::Now().ToString());
+	}
+}
+
+FArchive& operator<<(FArchive& Ar, FClimbingRecordedState& State)
+{
+	Ar << State.Location << State.Rotation << State.Velocity;
+	Ar << State.VerticalAxis << State.HorizontalAxis;
+	Ar << State.CharacterState << State.bIsMovingOnGround << State.bIsFlyingForwardInAir;
+	Ar << State.CurrentClimbable << State.NextClimbable;
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FClimbingRecordedMover& Mover)
+{
+	return Ar << Mover.Climbable << Mover.Location << Mover.Rotation;
+}
+
+bool FClimbingRecording::Load(const FString& Filename)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *Filename))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Couldn't read climbing recording %s"), *Filename);
+		return false;
+	}
+
+	FMemoryReader Reader(Bytes);
+
+	FClimbingRecordingHeader Header;
+	Reader << Header;
+	if (Reader.IsError() || Header.Magic != Magic || Header.Version != Version)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s isn't a climbing recording this build can read"), *Filename);
+		return false;
+	}
+
+	MapName = Header.MapName;
+	ClimbableNames.Reset();
+	Frames.Reset();
+
+	while (!Reader.AtEnd() && !Reader.IsError())
+	{
+		uint8 RecordType;
+		Reader << RecordType;
+
+		if (RecordType == CRT_Name)
+		{
+			Reader << ClimbableNames.AddDefaulted_GetRef();
+			continue;
+		}
+
+		if (RecordType == CRT_Frame)
+		{
+			auto& Frame = Frames.AddDefaulted_GetRef();
+			Reader << Frame.DeltaTime << Frame.MovingClimbables;
+			continue;
+		}
+
+		// Events from before the first tick, like a button press on the first frame, have nowhere to go
+		if (Frames.Num() == 0 || (RecordType != CRT_Detect && RecordType != CRT_Query))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Climbing recording %s is corrupt"), *Filename);
+			return false;
+		}
+
+		auto& Event = Frames.Last().Events.AddDefaulted_GetRef();
+		Event.bIsQuery = RecordType == CRT_Query;
+		Reader << Event.State;
+		if (Event.bIsQuery)
+		{
+			Reader << Event.InputDirection << Event.DetectionType << Event.Flags << Event.Result;
+		}
+		else
+		{
+			Reader << Event.Climbables;
+		}
+	}
+
+	// A recording that was cut off part way through a record still has everything before it
+	if (Reader.IsError() && Frames.Num() > 0)
+	{
+		Frames.Pop();
+		UE_LOG(LogTemp, Warning, TEXT("Climbing recording %s was cut off, replaying the first %d frames"), *Filename, Frames.Num());
+	}
+
+	return Frames.Num() > 0;
+}
+
+FString FClimbingRecording::GetClimbableName(const AClimbable* Climbable)
+{
+	// Play in editor puts a prefix on the package name, so leave that out and use the level's package and the actor's name
+	const auto PackageName = UWorld::RemovePIEPrefix(Climbable->GetOutermost()->GetName());
+	return FString::Printf(TEXT("%s.%s"), *PackageName, *Climbable->GetName());
+}
+
+void FClimbingRecording::ResolveClimbables(UWorld* World, TArray<AClimbable*>& OutClimbables) const
+{
+	TMap<FString, AClimbable*> ClimbablesByName;
+	for (TActorIterator<AClimbable> It(World); It; ++It)
+	{
+		ClimbablesByName.Add(GetClimbableName(*It), *It);
+	}
+
+	int32 NumMissing = 0;
+	OutClimbables.Reset(ClimbableNames.Num());
+	for (const auto& Name : ClimbableNames)
+	{
+		auto Climbable = ClimbablesByName.FindRef(Name);
+		NumMissing += Climbable == nullptr ? 1 : 0;
+		OutClimbables.Add(Climbable);
+	}
+
+	if (NumMissing > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%d of the recorded climbables aren't in this world, was it recorded on %s?"), NumMissing, *MapName);
+	}
+}
+
+FClimbingRecorder::~FClimbingRecorder()
+{
+	Stop();
+}
+
+bool FClimbingRecorder::Start(const FString& Filename, const UWorld* World)
+{
+	Stop();
+
+	Writer.Reset(IFileManager::Get().CreateFileWriter(*Filename));
+	if (!Writer.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Couldn't open %s to record climbing to"), *Filename);
+		return false;
+	}
+
+	FClimbingRecordingHeader Header;
+	Header.MapName = World->GetMapName();
+	*Writer << Header;
+
+	UE_LOG(LogTemp, Log, TEXT("Recording climbing to %s"), *Filename);
+	return true;
+}
+
+void FClimbingRecorder::Stop()
+{
+	if (Writer.IsValid())
+	{
+		Writer->Close();
+		Writer.Reset();
+	}
+	ClimbableIndices.Reset();
+}
+
+void FClimbingRecorder::RecordFrame(float DeltaTime, TArrayView<AClimbable* const> MovingClimbables)
+{
+	TArray<FClimbingRecordedMover, TInlineAllocator<16>> Movers;
+	for (auto Climbable : MovingClimbables)
+	{
+		auto& Mover = Movers.AddDefaulted_GetRef();
+		Mover.Climbable = GetClimbableIndex(Climbable);
+		Mover.Location = Climbable->GetActorLocation();
+		Mover.Rotation = Climbable->GetActorRotation();
+	}
+
+	uint8 RecordType = FClimbingRecording::CRT_Frame;
+	*Writer << RecordType << DeltaTime << Movers;
+}
+
+void FClimbingRecorder::RecordDetect(const FClimbingRecordedState& State, TArrayView<AClimbable* const> PossibleClimbables)
+{
+	TArray<int32, TInlineAllocator<64>> Climbables;
+	for (auto Climbable : PossibleClimbables)
+	{
+		Climbables.Add(GetClimbableIndex(Climbable));
+	}
+
+	uint8 RecordType = FClimbingRecording::CRT_Detect;
+	auto StateCopy = State;
+	*Writer << RecordType << StateCopy << Climbables;
+}
+
+void FClimbingRecorder::RecordQuery(const FClimbingRecordedState& State, FVector2D InputDirection, uint8 DetectionType, uint8 Flags,
+                                    const AClimbable* Result)
+{
+	auto ResultIndex = GetClimbableIndex(Result);
+
+	uint8 RecordType = FClimbingRecording::CRT_Query;
+	auto StateCopy = State;
+	*Writer << RecordType << StateCopy << InputDirection << DetectionType << Flags << ResultIndex;
+}
+
+int32 FClimbingRecorder::GetClimbableIndex(const AClimbable* Climbable)
+{
+	if (Climbable == nullptr)
+	{
+		return INDEX_NONE;
+	}
+
+	if (auto Index = ClimbableIndices.Find(Climbable))
+	{
+		return *Index;
+	}
+
+	const auto Index = ClimbableIndices.Num();
+	ClimbableIndices.Add(Climbable, Index);
+
+	uint8 RecordType = FClimbingRecording::CRT_Name;
+	auto Name = FClimbingRecording::GetClimbableName(Climbable);
+	*Writer << RecordType << Name;
+	return Index;
+}
+
+static FAutoConsoleCommandWithWorldAndArgs ClimbingRecordStartCommand(
+	TEXT("Climbing.Record.Start"),
+	TEXT("Records what the player's climbing component reads every tick, to the given file or to Saved/Climbing. ")
+	TEXT("Play it back with Climbing.Replay."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (auto ClimbingComponent = FindPlayerClimbingComponent(World))
+		{
+			ClimbingComponent->StartClimbingRecording(GetRecordingFilename(Args));
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs ClimbingRecordStopCommand(
+	TEXT("Climbing.Record.Stop"),
+	TEXT("Stops the recording started with Climbing.Record.Start."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (auto ClimbingComponent = FindPlayerClimbingComponent(World))
+		{
+			ClimbingComponent->StopClimbingRecording();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs ClimbingReplayCommand(
+	TEXT("Climbing.Replay"),
+	TEXT("Feeds a climbing recording back through the player's climbing component, one recorded tick per frame, ")
+	TEXT("then logs how long it took and anywhere it picked different climbables than when it was recorded."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (Args.Num() == 0)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Climbing.Replay needs the recording to play back"));
+			return;
+		}
+
+		if (auto ClimbingComponent = FindPlayerClimbingComponent(World))
+		{
+			ClimbingComponent->StartClimbingReplay(Args[0]);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs ClimbingReplayStopCommand(
+	TEXT("Climbing.Replay.Stop"),
+	TEXT("Stops a replay started with Climbing.Replay, and logs the results so far."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (auto ClimbingComponent = FindPlayerClimbingComponent(World))
+		{
+			ClimbingComponent->StopClimbingReplay();
+		}
+	}));
@@ -0,0 +1,130 @@
+/* Copyright 2019 Alexandrea Shackelford, Zion Nimchuk, All Rights Reserved.
+ * Unauthorized copying or modification of this file, via any medium is strictly prohibited.
+ */
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AClimbable;
+class UWorld;
+
+/* What UClimbingComponent was working from when it detected or picked a climbable*/
+struct FClimbingRecordedState
+{
+	FVector Location = FVector::ZeroVector;
+	FRotator Rotation = FRotator::ZeroRotator;
+	FVector Velocity = FVector::ZeroVector;
+
+	/* Only kept for looking at, replays get the input direction from the recorded queries instead*/
+	float VerticalAxis = 0.0f;
+	float HorizontalAxis = 0.0f;
+
+	uint8 CharacterState = 0;
+	bool bIsMovingOnGround = false;
+	bool bIsFlyingForwardInAir = false;
+
+	/* Indices into the recording's climbable names, INDEX_NONE for nullptr*/
+	int32 CurrentClimbable = INDEX_NONE;
+	int32 NextClimbable = INDEX_NONE;
+
+	friend FArchive& operator<<(FArchive& Ar, FClimbingRecordedState& State);
+};
+
+/* Either a DetectClimbables call and what it found, or a FindBestClimbable call and what it picked*/
+struct FClimbingRecordedEvent
+{
+	enum EFlags : uint8
+	{
+		CRF_CanWaitForAsyncQueries = 1 << 0,
+		CRF_UsedAsyncObstructionQueries = 1 << 1
+	};
+
+	bool bIsQuery = false;
+	FClimbingRecordedState State;
+
+	/* Detection only, the PossibleClimbables that came out of it*/
+	TArray<int32> Climbables;
+
+	/* Queries only*/
+	FVector2D InputDirection = FVector2D::ZeroVector;
+	uint8 DetectionType = 0;
+	uint8 Flags = 0;
+	int32 Result = INDEX_NONE;
+};
+
+/* Where a moving climbable was at the start of a tick*/
+struct FClimbingRecordedMover
+{
+	int32 Climbable = INDEX_NONE;
+	FVector Location = FVector::ZeroVector;
+	FRotator Rotation = FRotator::ZeroRotator;
+
+	friend FArchive& operator<<(FArchive& Ar, FClimbingRecordedMover& Mover);
+};
+
+struct FClimbingRecordedFrame
+{
+	float DeltaTime = 0.0f;
+	TArray<FClimbingRecordedMover> MovingClimbables;
+	TArray<FClimbingRecordedEvent> Events;
+};
+
+/**
+ * A climbing session read back from disk.
+ * The file starts with a small header, followed by a stream of records that each begin with their type. Climbables are written
+ * as their path name the first time they show up, and as an index into those names after that.
+ */
+struct FClimbingRecording
+{
+	static constexpr uint32 Magic = 0x524D4C43;
+	static constexpr uint32 Version = 1;
+
+	enum ERecordType : uint8
+	{
+		CRT_Name, CRT_Frame, CRT_Detect, CRT_Query
+	};
+
+	FString MapName;
+	TArray<FString> ClimbableNames;
+	TArray<FClimbingRecordedFrame> Frames;
+
+	/* Returns false if the file couldn't be read, or isn't a recording this version can read*/
+	bool Load(const FString& Filename);
+
+	/* The name a climbable is recorded under, which is the same in the editor and in a packaged game*/
+	static FString GetClimbableName(const AClimbable* Climbable);
+
+	/* Finds the climbables the names refer to, anything that's missing from the world comes back as nullptr*/
+	void ResolveClimbables(UWorld* World, TArray<AClimbable*>& OutClimbables) const;
+};
+
+/**
+ * Streams what a climbing component reads each tick to disk, so that it can be fed back through DetectClimbables and
+ * FindBestClimbable later. Started and stopped with Climbing.Record.Start and Climbing.Record.Stop.
+ */
+class FClimbingRecorder
+{
+public:
+
+	~FClimbingRecorder();
+
+	bool Start(const FString& Filename, const UWorld* World);
+	void Stop();
+
+	bool IsRecording() const { return Writer.IsValid(); }
+
+	/* Starts a new tick, moving climbables are written out here since they're the only part of the level that changes*/
+	void RecordFrame(float DeltaTime, TArrayView<AClimbable* const> MovingClimbables);
+
+	void RecordDetect(const FClimbingRecordedState& State, TArrayView<AClimbable* const> PossibleClimbables);
+
+	void RecordQuery(const FClimbingRecordedState& State, FVector2D InputDirection, uint8 DetectionType, uint8 Flags, const AClimbable* Result);
+
+	/* The index a climbable is written as, writing out its name first if this is the first time it's been seen*/
+	int32 GetClimbableIndex(const AClimbable* Climbable);
+
+private:
+
+	TUniquePtr<FArchive> Writer;
+	TMap<const AClimbable*, int32> ClimbableIndices;
+};
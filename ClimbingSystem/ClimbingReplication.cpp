@@ -0,0 +1,42 @@
+/* Copyright 2019 Alexandrea Shackelford, Zion Nimchuk, All Rights Reserved.
+ * Unauthorized copying or modification of this file, via any medium is strictly prohibited.
+ */
+
+#include "ClimbingReplication.h"
+#include "World/Climbable.h"
+#include "Engine/NetSerialization.h"
+#include "UObject/CoreNet.h"
+
+bool FReplicatedClimbState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	uint8 bClimbingBit = bIsClimbing ? 1 : 0;
+	Ar.SerializeBits(&bClimbingBit, 1);
+	bIsClimbing = bClimbingBit != 0;
+
+	Ar << PredictionId;
+	Ar << Sequence;
+
+	if (!bIsClimbing)
+	{
+		if (Ar.IsLoading())
+		{
+			Climbable = nullptr;
+		}
+		return true;
+	}
+
+	// Climbables placed in the level are named the same everywhere, so this is only a small index into the package map
+	UObject* ClimbableObject = Climbable;
+	bOutSuccess &= Map->SerializeObject(Ar, AClimbable::StaticClass(), ClimbableObject);
+	Climbable = Cast<AClimbable>(ClimbableObject);
+
+	Ar << StartTime;
+
+	// Millimetre precision is plenty for where a jump starts
+	bOutSuccess &= SerializePackedVector<10, 24>(StartLocation, Ar);
+	StartRotation.SerializeCompressedShort(Ar);
+
+	return true;
+}
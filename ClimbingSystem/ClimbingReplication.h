@@ -0,0 +1,57 @@
+/* Copyright 2019 Alexandrea Shackelford, Zion Nimchuk, All Rights Reserved.
+ * Unauthorized copying or modification of this file, via any medium is strictly prohibited.
+ */
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ClimbingReplication.generated.h"
+
+class AClimbable;
+
+/**
+ * Everything a remote machine needs to play a climbing jump back the same way the server does. It's only sent when a jump starts
+ * or we let go, the lerp in UpdateMovement is rebuilt from the start pose and time, so nothing gets sent while we're in the air
+ * or hanging.
+ */
+USTRUCT()
+struct FReplicatedClimbState
+{
+	GENERATED_BODY()
+
+	/* What we're jumping to or hanging off*/
+	UPROPERTY()
+	AClimbable* Climbable = nullptr;
+
+	/* False once we've let go, none of the jump is sent then*/
+	UPROPERTY()
+	bool bIsClimbing = false;
+
+	/* The last prediction from the owning client that the server acted on, so it can tell its own jumps coming back*/
+	UPROPERTY()
+	uint8 PredictionId = 0;
+
+	/* Goes up on every change, so jumping to the same climbable twice still gets sent*/
+	UPROPERTY()
+	uint8 Sequence = 0;
+
+	/* Server world time the jump started at*/
+	UPROPERTY()
+	float StartTime = 0.0f;
+
+	UPROPERTY()
+	FVector StartLocation = FVector::ZeroVector;
+
+	UPROPERTY()
+	FRotator StartRotation = FRotator::ZeroRotator;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template <>
+struct TStructOpsTypeTraits<FReplicatedClimbState> : public TStructOpsTypeTraitsBase2<FReplicatedClimbState>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
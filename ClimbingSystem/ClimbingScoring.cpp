@@ -0,0 +1,159 @@
+/* Copyright 2019 Alexandrea Shackelford, Zion Nimchuk, All Rights Reserved.
+ * Unauthorized copying or modification of this file, via any medium is strictly prohibited.
+ */
+
+#include "ClimbingScoring.h"
+#include "Async/ParallelFor.h"
+#include "ClimbingStats.h"
+#include "World/Climbable.h"
+#include "World/SplineLedge.h"
+
+void FClimbableScoringBatch::Reset(int32 NewNum)
+{
+	Num = NewNum;
+	const auto PaddedNum = Align(NewNum, VectorWidth);
+
+	PositionX.SetNumUninitialized(PaddedNum, /*bAllowShrinking: */false);
+	PositionY.SetNumUninitialized(PaddedNum, false);
+	PositionZ.SetNumUninitialized(PaddedNum, false);
+	Yaw.SetNumUninitialized(PaddedNum, false);
+	Pitch.SetNumUninitialized(PaddedNum, false);
+	Eligible.SetNumUninitialized(PaddedNum, false);
+	Ratings.SetNumUninitialized(PaddedNum, false);
+
+	// The padding needs to be valid numbers, but it'll never be picked
+	for (int32 i = NewNum; i < PaddedNum; i++)
+	{
+		PositionX[i] = PositionY[i] = PositionZ[i] = 0.0f;
+		Yaw[i] = Pitch[i] = 0.0f;
+		Eligible[i] = 0.0f;
+	}
+}
+
+ClimbingCore::FCandidateArrays FClimbableScoringBatch::GetArrays()
+{
+	ClimbingCore::FCandidateArrays Arrays;
+	Arrays.PositionX = PositionX.GetData();
+	Arrays.PositionY = PositionY.GetData();
+	Arrays.PositionZ = PositionZ.GetData();
+	Arrays.Yaw = Yaw.GetData();
+	Arrays.Pitch = Pitch.GetData();
+	Arrays.Eligible = Eligible.GetData();
+	Arrays.Ratings = Ratings.GetData();
+	return Arrays;
+}
+
+void ClimbingScoring::ScoreCandidates(const ClimbingCore::FScoringParams& Params, FClimbableScoringBatch& Batch)
+{
+	CLIMBING_SCOPE_CYCLE_COUNTER(STAT_Climbing_ScoreCandidates);
+
+	const auto PaddedNum = Align(Batch.Num, FClimbableScoringBatch::VectorWidth);
+	const auto Arrays = Batch.GetArrays();
+
+	if (Batch.Num < FClimbableScoringBatch::ParallelThreshold)
+	{
+		ClimbingCore::ScoreCandidates(Params, Arrays, 0, PaddedNum);
+		return;
+	}
+
+	const auto NumChunks = FMath::DivideAndRoundUp(PaddedNum, FClimbableScoringBatch::ParallelChunkSize);
+	ParallelFor(NumChunks, [&](int32 ChunkIndex)
+	{
+		const auto Start = ChunkIndex * FClimbableScoringBatch::ParallelChunkSize;
+		const auto End = FMath::Min(Start + FClimbableScoringBatch::ParallelChunkSize, PaddedNum);
+		ClimbingCore::ScoreCandidates(Params, Arrays, Start, End);
+	});
+}
+
+namespace
+{
+	struct FCandidateRatingPredicate
+	{
+		const FClimbableScoringBatch& Batch;
+
+		FORCEINLINE bool operator()(int32 A, int32 B) const
+		{
+			const auto RatingA = Batch.Ratings[A];
+			const auto RatingB = Batch.Ratings[B];
+			return RatingA > RatingB || (RatingA == RatingB && A < B);
+		}
+	};
+}
+
+void ClimbingScoring::BuildCandidateHeap(const FClimbableScoringBatch& Batch, TArray<int32>& OutHeap)
+{
+	OutHeap.Reset();
+	for (int32 i = 0; i < Batch.Num; i++)
+	{
+		if (Batch.Ratings[i] > 0.0f)
+		{
+			OutHeap.Add(i);
+		}
+	}
+	OutHeap.Heapify(FCandidateRatingPredicate{Batch});
+}
+
+int32 ClimbingScoring::PopBestCandidate(const FClimbableScoringBatch& Batch, TArray<int32>& Heap)
+{
+	if (Heap.Num() == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	int32 BestIndex;
+	Heap.HeapPop(BestIndex, FCandidateRatingPredicate{Batch}, /*bAllowShrinking: */false);
+	return BestIndex;
+}
+
+void ClimbingScoring::FilterReachable(const AActor* From, const FClimbReachabilitySettings& Settings,
+                                      TArrayView<AClimbable* const> Candidates, FClimbableScoringBatch& Batch,
+                                      TArray<int32>& OutReachable)
+{
+	OutReachable.Reset();
+
+	// Same pose GetHangingPosition gives, with the capsule upright like it is when we grab on
+	const auto Pose = ClimbingCore::GetHangingPose(ToClimbingCore(From->GetActorLocation()), ToClimbingCore(From->GetActorForwardVector()),
+		ToClimbingCore(FVector::UpVector), Settings.CapsuleHalfHeight, Settings.DistanceFromClimbTarget.X, Settings.DistanceFromClimbTarget.Z);
+	const FRotator HangingRotation(Pose.Pitch, Pose.Yaw, 0.0f);
+
+	ClimbingCore::FScoringInputs ScoringInputs;
+	ScoringInputs.DetectionType = ClimbingCore::EDetectionType::IsClimbing;
+	ScoringInputs.bIsAttached = true;
+	ScoringInputs.Origin = Pose.Location;
+	ScoringInputs.LocalAxisX = ToClimbingCore(HangingRotation.Vector());
+	ScoringInputs.DirectionAxisX = ScoringInputs.LocalAxisX;
+	ScoringInputs.DirectionAxisY = ToClimbingCore(FRotationMatrix(HangingRotation).GetUnitAxis(EAxis::Y));
+	ScoringInputs.OwnerYaw = Pose.Yaw;
+	ScoringInputs.OwnerPitch = Pose.Pitch;
+	ScoringInputs.CapsuleHalfHeight = Settings.CapsuleHalfHeight;
+	ScoringInputs.MaxYawDelta = Settings.MaxRotationDelta;
+	ScoringInputs.MaxPitchDelta = Settings.MaxRotationDelta;
+
+	auto Params = ClimbingCore::MakeScoringParams(ScoringInputs);
+
+	// The stick direction is only known when we actually jump, so that filter still gets run then
+	Params.bRejectOutsideDirection = false;
+
+	Batch.Reset(Candidates.Num());
+	for (int32 i = 0; i < Candidates.Num(); i++)
+	{
+		const auto Location = Candidates[i]->GetActorLocation();
+		const auto Rotation = Candidates[i]->GetActorRotation();
+		Batch.PositionX[i] = Location.X;
+		Batch.PositionY[i] = Location.Y;
+		Batch.PositionZ[i] = Location.Z;
+		Batch.Yaw[i] = Rotation.Yaw;
+		Batch.Pitch[i] = Rotation.Pitch;
+		Batch.Eligible[i] = Cast<ASplineLedge>(Candidates[i]) != nullptr ? 0.0f : 1.0f;
+	}
+
+	ScoreCandidates(Params, Batch);
+
+	for (int32 i = 0; i < Candidates.Num(); i++)
+	{
+		if (Batch.Ratings[i] > 0.0f || Cast<ASplineLedge>(Candidates[i]) != nullptr)
+		{
+			OutReachable.Add(i);
+		}
+	}
+}
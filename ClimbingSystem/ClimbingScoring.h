@@ -0,0 +1,88 @@
+/* Copyright 2019 Alexandrea Shackelford, Zion Nimchuk, All Rights Reserved.
+ * Unauthorized copying or modification of this file, via any medium is strictly prohibited.
+ */
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ClimbingCore.h"
+
+class AClimbable;
+
+inline ClimbingCore::FVec3 ToClimbingCore(const FVector& Vector)
+{
+	return {Vector.X, Vector.Y, Vector.Z};
+}
+
+inline FVector FromClimbingCore(const ClimbingCore::FVec3& Vector)
+{
+	return {Vector.X, Vector.Y, Vector.Z};
+}
+
+/**
+ * Candidates gathered into contiguous arrays for the scoring pass. Every array is padded to a multiple of the vector width,
+ * padding entries are never eligible.
+ */
+struct FClimbableScoringBatch
+{
+	static constexpr int32 Alignment = 16;
+	static constexpr int32 VectorWidth = ClimbingCore::FCandidateArrays::VectorWidth;
+
+	/* Candidate count above which scoring is split across worker threads*/
+	static constexpr int32 ParallelThreshold = 1024;
+	static constexpr int32 ParallelChunkSize = 256;
+
+	TArray<float, TAlignedHeapAllocator<Alignment>> PositionX;
+	TArray<float, TAlignedHeapAllocator<Alignment>> PositionY;
+	TArray<float, TAlignedHeapAllocator<Alignment>> PositionZ;
+	TArray<float, TAlignedHeapAllocator<Alignment>> Yaw;
+	TArray<float, TAlignedHeapAllocator<Alignment>> Pitch;
+
+	/* 1 when the candidate should be scored, 0 when it was already thrown out*/
+	TArray<float, TAlignedHeapAllocator<Alignment>> Eligible;
+
+	/* Output, 0 for rejected candidates*/
+	TArray<float, TAlignedHeapAllocator<Alignment>> Ratings;
+
+	int32 Num = 0;
+
+	/* Sizes every array for NewNum candidates, without giving back memory*/
+	void Reset(int32 NewNum);
+
+	ClimbingCore::FCandidateArrays GetArrays();
+};
+
+/* The tunables that decide what can be jumped to while hanging off a climbable*/
+struct FClimbReachabilitySettings
+{
+	float CapsuleHalfHeight = 0.0f;
+
+	/* UClimbingComponent::DistanceFromClimbTarget*/
+	FVector DistanceFromClimbTarget = FVector::ZeroVector;
+
+	/* UClimbingComponent::MaxYRotation, which FindBestClimbable uses for both yaw and pitch*/
+	float MaxRotationDelta = 0.0f;
+};
+
+namespace ClimbingScoring
+{
+	/* Runs the geometric filters and the rating formula on every candidate in the batch*/
+	void ScoreCandidates(const ClimbingCore::FScoringParams& Params, FClimbableScoringBatch& Batch);
+
+	/**
+	 * \brief Builds a heap of every candidate with a positive rating, so that they can be taken out best first without sorting all of them.
+	 * Ties go to whichever candidate came first, same as a plain search for the highest rating.
+	 */
+	void BuildCandidateHeap(const FClimbableScoringBatch& Batch, TArray<int32>& OutHeap);
+
+	/* Takes the best remaining candidate out of the heap, or returns INDEX_NONE when it's empty*/
+	int32 PopBestCandidate(const FClimbableScoringBatch& Batch, TArray<int32>& Heap);
+
+	/**
+	 * \brief Finds which of the candidates can be jumped to while hanging off From, with the stick pushed in any direction.
+	 * Ledges are always kept, whether we can go up them is only decided by their climb up transform once we're there.
+	 * \param Batch Scratch space for the scoring
+	 * \param OutReachable Filled with the indices into Candidates of the reachable ones
+	 */
+	void FilterReachable(const AActor* From, const FClimbReachabilitySettings& Settings, TArrayView<AClimbable* const> Candidates,
+		FClimbableScoringBatch& Batch, TArray<int32>& OutReachable);
+}
@@ -0,0 +1,49 @@
+/* Copyright 2019 Alexandrea Shackelford, Zion Nimchuk, All Rights Reserved.
+ * Unauthorized copying or modification of this file, via any medium is strictly prohibited.
+ */
+
+#include "ClimbingStats.h"
+
+DEFINE_STAT(STAT_Climbing_Tick);
+DEFINE_STAT(STAT_Climbing_BatchedTick);
+DEFINE_STAT(STAT_Climbing_ComputeTick);
+DEFINE_STAT(STAT_Climbing_RunAgainstWallChecker);
+DEFINE_STAT(STAT_Climbing_DetectClimbables);
+DEFINE_STAT(STAT_Climbing_FindBestClimbable);
+DEFINE_STAT(STAT_Climbing_ScoreCandidates);
+DEFINE_STAT(STAT_Climbing_IsPlayerCapsuleInsideCollision);
+DEFINE_STAT(STAT_Climbing_GetHangingPosition);
+DEFINE_STAT(STAT_Climbing_UpdateMovement);
+DEFINE_STAT(STAT_Climbing_IssueAsyncObstructionQueries);
+DEFINE_STAT(STAT_Climbing_IndexQuery);
+DEFINE_STAT(STAT_Climbing_LedgeClimbUpTransform);
+DEFINE_STAT(STAT_Climbing_RoutePlanning);
+DEFINE_STAT(STAT_Climbing_Queries);
+DEFINE_STAT(STAT_Climbing_Candidates);
+DEFINE_STAT(STAT_Climbing_GraphDetections);
+DEFINE_STAT(STAT_Climbing_CandidatesLastQuery);
+DEFINE_STAT(STAT_Climbing_RouteNodesExpanded);
+DEFINE_STAT(STAT_Climbing_RejectedNotClimbable);
+DEFINE_STAT(STAT_Climbing_RejectedLedge);
+DEFINE_STAT(STAT_Climbing_RejectedByFilters);
+DEFINE_STAT(STAT_Climbing_RejectedObstructed);
+DEFINE_STAT(STAT_Climbing_ObstructionQueries);
+DEFINE_STAT(STAT_Climbing_AsyncObstructionQueries);
+DEFINE_STAT(STAT_Climbing_BatchedObstructionTests);
+DEFINE_STAT(STAT_Climbing_ObstructionQueriesLastPress);
+DEFINE_STAT(STAT_Climbing_MovingClimbableValidations);
+DEFINE_STAT(STAT_Climbing_JumpPathSweeps);
+DEFINE_STAT(STAT_Climbing_TrajectoryPrefetches);
+DEFINE_STAT(STAT_Climbing_DetectionCacheHits);
+DEFINE_STAT(STAT_Climbing_DetectionCacheMisses);
+DEFINE_STAT(STAT_Climbing_HangingCacheHits);
+DEFINE_STAT(STAT_Climbing_HangingCacheMisses);
+DEFINE_STAT(STAT_Climbing_LedgeMemoHits);
+DEFINE_STAT(STAT_Climbing_LedgeMemoMisses);
+DEFINE_STAT(STAT_Climbing_SharedQueryHits);
+DEFINE_STAT(STAT_Climbing_SharedQueryMisses);
+DEFINE_STAT(STAT_Climbing_AsyncObstructionHits);
+DEFINE_STAT(STAT_Climbing_AsyncObstructionMisses);
+DEFINE_STAT(STAT_Climbing_ObstructionCacheHits);
+DEFINE_STAT(STAT_Climbing_ObstructionCacheMisses);
+DEFINE_STAT(STAT_Climbing_ObstructionCacheInvalidations);
@@ -0,0 +1,76 @@
+/* Copyright 2019 Alexandrea Shackelford, Zion Nimchuk, All Rights Reserved.
+ * Unauthorized copying or modification of this file, via any medium is strictly prohibited.
+ */
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+/**
+ * Everything the climbing system reports to "stat Climbing". The cycle stats also show up as named scopes in Unreal Insights,
+ * through CLIMBING_SCOPE_CYCLE_COUNTER. Counters reset every frame, so they read as "per frame".
+ */
+DECLARE_STATS_GROUP(TEXT("Climbing"), STATGROUP_Climbing, STATCAT_Advanced);
+
+/* Phases of the tick*/
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Tick"), STAT_Climbing_Tick, STATGROUP_Climbing, THEELDER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Batched Tick"), STAT_Climbing_BatchedTick, STATGROUP_Climbing, THEELDER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ComputeTick"), STAT_Climbing_ComputeTick, STATGROUP_Climbing, THEELDER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("RunAgainstWallChecker"), STAT_Climbing_RunAgainstWallChecker, STATGROUP_Climbing, THEELDER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("DetectClimbables"), STAT_Climbing_DetectClimbables, STATGROUP_Climbing, THEELDER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("FindBestClimbable"), STAT_Climbing_FindBestClimbable, STATGROUP_Climbing, THEELDER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ScoreCandidates"), STAT_Climbing_ScoreCandidates, STATGROUP_Climbing, THEELDER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("IsPlayerCapsuleInsideCollision"), STAT_Climbing_IsPlayerCapsuleInsideCollision, STATGROUP_Climbing, THEELDER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("GetHangingPosition"), STAT_Climbing_GetHangingPosition, STATGROUP_Climbing, THEELDER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("UpdateMovement"), STAT_Climbing_UpdateMovement, STATGROUP_Climbing, THEELDER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("IssueAsyncObstructionQueries"), STAT_Climbing_IssueAsyncObstructionQueries, STATGROUP_Climbing, THEELDER_API);
+
+/* The climbable index*/
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Index Query"), STAT_Climbing_IndexQuery, STATGROUP_Climbing, THEELDER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Ledge Climb Up Transform"), STAT_Climbing_LedgeClimbUpTransform, STATGROUP_Climbing, THEELDER_API);
+
+/* Candidates*/
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("FindBestClimbable Calls"), STAT_Climbing_Queries, STATGROUP_Climbing, THEELDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Candidates Considered"), STAT_Climbing_Candidates, STATGROUP_Climbing, THEELDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Baked Graph Detections"), STAT_Climbing_GraphDetections, STATGROUP_Climbing, THEELDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Trajectory Prefetches"), STAT_Climbing_TrajectoryPrefetches, STATGROUP_Climbing, THEELDER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Candidates Last Query"), STAT_Climbing_CandidatesLastQuery, STATGROUP_Climbing, THEELDER_API);
+
+/* Why candidates got thrown out, in the order the checks happen*/
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Rejected: Not Climbable"), STAT_Climbing_RejectedNotClimbable, STATGROUP_Climbing, THEELDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Rejected: Ledge"), STAT_Climbing_RejectedLedge, STATGROUP_Climbing, THEELDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Rejected: Position/Angle"), STAT_Climbing_RejectedByFilters, STATGROUP_Climbing, THEELDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Rejected: Obstructed"), STAT_Climbing_RejectedObstructed, STATGROUP_Climbing, THEELDER_API);
+
+/* Obstruction queries*/
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Obstruction Queries"), STAT_Climbing_ObstructionQueries, STATGROUP_Climbing, THEELDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Async Obstruction Queries"), STAT_Climbing_AsyncObstructionQueries, STATGROUP_Climbing, THEELDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Batched Obstruction Tests"), STAT_Climbing_BatchedObstructionTests, STATGROUP_Climbing, THEELDER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Obstruction Queries Last Press"), STAT_Climbing_ObstructionQueriesLastPress, STATGROUP_Climbing, THEELDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Moving Climbable Obstruction Checks"), STAT_Climbing_MovingClimbableValidations, STATGROUP_Climbing, THEELDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Jump Path Sweeps"), STAT_Climbing_JumpPathSweeps, STATGROUP_Climbing, THEELDER_API);
+
+/* Route planning*/
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Route Planning"), STAT_Climbing_RoutePlanning, STATGROUP_Climbing, THEELDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Route Nodes Expanded"), STAT_Climbing_RouteNodesExpanded, STATGROUP_Climbing, THEELDER_API);
+
+/* Caches, hits against misses*/
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Detection Cache Hits"), STAT_Climbing_DetectionCacheHits, STATGROUP_Climbing, THEELDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Detection Cache Misses"), STAT_Climbing_DetectionCacheMisses, STATGROUP_Climbing, THEELDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Hanging Transform Cache Hits"), STAT_Climbing_HangingCacheHits, STATGROUP_Climbing, THEELDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Hanging Transform Cache Misses"), STAT_Climbing_HangingCacheMisses, STATGROUP_Climbing, THEELDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Ledge Memo Hits"), STAT_Climbing_LedgeMemoHits, STATGROUP_Climbing, THEELDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Ledge Memo Misses"), STAT_Climbing_LedgeMemoMisses, STATGROUP_Climbing, THEELDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Shared Query Hits"), STAT_Climbing_SharedQueryHits, STATGROUP_Climbing, THEELDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Shared Query Misses"), STAT_Climbing_SharedQueryMisses, STATGROUP_Climbing, THEELDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Async Obstruction Result Hits"), STAT_Climbing_AsyncObstructionHits, STATGROUP_Climbing, THEELDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Async Obstruction Result Misses"), STAT_Climbing_AsyncObstructionMisses, STATGROUP_Climbing, THEELDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Obstruction Cache Hits"), STAT_Climbing_ObstructionCacheHits, STATGROUP_Climbing, THEELDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Obstruction Cache Misses"), STAT_Climbing_ObstructionCacheMisses, STATGROUP_Climbing, THEELDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Obstruction Cache Invalidations"), STAT_Climbing_ObstructionCacheInvalidations, STATGROUP_Climbing, THEELDER_API);
+
+/* A cycle stat that's also a named Insights scope, so the phases line up in both tools*/
+#define CLIMBING_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE(Stat)
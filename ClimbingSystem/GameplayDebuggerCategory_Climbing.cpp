@@ -0,0 +1,153 @@
+/* Copyright 2019 Alexandrea Shackelford, Zion Nimchuk, All Rights Reserved.
+ * Unauthorized copying or modification of this file, via any medium is strictly prohibited.
+ */
+
+#include "GameplayDebuggerCategory_Climbing.h"
+
+#if WITH_GAMEPLAY_DEBUGGER && WITH_CLIMBING_DEBUG
+
+#include "ClimbingComponent.h"
+#include "World/Climbable.h"
+#include "GameFramework/Actor.h"
+#include "GameplayDebugger.h"
+#include "Misc/DelayedAutoRegister.h"
+
+namespace
+{
+	FDelayedAutoRegisterHelper GRegisterClimbingCategory(EDelayedRegisterRunPhase::EndOfEngineInit, []
+	{
+		if (IGameplayDebugger::IsAvailable())
+		{
+			auto& GameplayDebugger = IGameplayDebugger::Get();
+			GameplayDebugger.RegisterCategory(TEXT("Climbing"),
+				IGameplayDebugger::FOnGetCategory::CreateStatic(&FGameplayDebuggerCategory_Climbing::MakeInstance),
+				EGameplayDebuggerCategoryState::EnabledInGameAndSimulate);
+			GameplayDebugger.NotifyCategoriesChanged();
+		}
+	});
+
+	const TCHAR* GetRejectionName(EClimbingDebugRejection Rejection)
+	{
+		switch (Rejection)
+		{
+		case EClimbingDebugRejection::NotClimbable:
+			return TEXT("not climbable");
+		case EClimbingDebugRejection::Ledge:
+			return TEXT("ledge");
+		case EClimbingDebugRejection::Filters:
+			return TEXT("position/angle");
+		case EClimbingDebugRejection::Obstructed:
+			return TEXT("obstructed");
+		case EClimbingDebugRejection::Pending:
+			return TEXT("waiting on async check");
+		case EClimbingDebugRejection::NotReached:
+			return TEXT("not reached");
+		default:
+			return TEXT("");
+		}
+	}
+
+	FColor GetRejectionColor(EClimbingDebugRejection Rejection)
+	{
+		switch (Rejection)
+		{
+		case EClimbingDebugRejection::None:
+			return FColor::Green;
+		case EClimbingDebugRejection::Obstructed:
+			return FColor::Red;
+		case EClimbingDebugRejection::Pending:
+			return FColor::Orange;
+		case EClimbingDebugRejection::NotReached:
+			return FColor::White;
+		default:
+			return FColor::Silver;
+		}
+	}
+}
+
+FGameplayDebuggerCategory_Climbing::FGameplayDebuggerCategory_Climbing()
+{
+	bShowOnlyWithDebugActor = true;
+}
+
+TSharedRef<FGameplayDebuggerCategory> FGameplayDebuggerCategory_Climbing::MakeInstance()
+{
+	return MakeShareable(new FGameplayDebuggerCategory_Climbing());
+}
+
+void FGameplayDebuggerCategory_Climbing::CollectData(APlayerController* OwnerPC, AActor* DebugActor)
+{
+	auto Climbing = DebugActor != nullptr ? DebugActor->FindComponentByClass<UClimbingComponent>() : nullptr;
+	if (Climbing == nullptr)
+	{
+		AddTextLine(TEXT("{red}No climbing component"));
+		return;
+	}
+
+	// Asking for it is what keeps the component filling it in, so the first frame after opening the category is empty
+	const auto& Snapshot = Climbing->RequestDebugSnapshot();
+
+	static const TCHAR* const StateNames[] = {TEXT("On ground"), TEXT("Climbing"), TEXT("Falling")};
+	AddTextLine(FString::Printf(TEXT("{white}State: {yellow}%s  {white}On: {yellow}%s  {white}Jumping to: {yellow}%s"),
+		StateNames[Climbing->CharacterState], *GetNameSafe(Climbing->CurrentClimbable), *GetNameSafe(Climbing->NextClimbable)));
+
+	AddTextLine(FString::Printf(TEXT("{white}Detection: {yellow}%s, %d candidates"),
+		Snapshot.DetectionSource, Climbing->PossibleClimbables.Num()));
+
+	const auto DetectionColor = Snapshot.bDetectedAny ? FColor::Green : FColor::Red;
+	if (Snapshot.bDetectedWithCapsule)
+	{
+		AddShape(FGameplayDebuggerShape::MakeCapsule(Snapshot.DetectionCenter, Snapshot.DetectionRadius, Snapshot.DetectionHalfHeight,
+			DetectionColor));
+	}
+	else
+	{
+		AddShape(FGameplayDebuggerShape::MakePoint(Snapshot.DetectionCenter, Snapshot.DetectionRadius, DetectionColor));
+	}
+
+	if (Snapshot.QueryFrame == 0)
+	{
+		AddTextLine(TEXT("{white}Last pick: {white}nothing picked yet"));
+		return;
+	}
+
+	AddTextLine(FString::Printf(TEXT("{white}Last pick: {yellow}%s {white}%llu frames ago, {yellow}%u {white}obstruction queries"),
+		*GetNameSafe(Snapshot.Picked.Get()), GFrameCounter - Snapshot.QueryFrame, Snapshot.NumObstructionQueries));
+
+	AddShape(FGameplayDebuggerShape::MakeSegment(Snapshot.QueryOrigin, Snapshot.QueryOrigin + Snapshot.QueryDirection * 100.0f, 5.0f,
+		FColor::Blue, TEXT("Input")));
+
+	for (const auto& Candidate : Snapshot.Candidates)
+	{
+		FString Description;
+		if (Candidate.Rejection == EClimbingDebugRejection::None)
+		{
+			Description = FString::Printf(TEXT("%d"), FMath::RoundToInt(Candidate.Rating));
+		}
+		else if (Candidate.ObstructedBy.IsValid())
+		{
+			Description = FString::Printf(TEXT("%d, obstructed by %s"), FMath::RoundToInt(Candidate.Rating), *Candidate.ObstructedBy->GetName());
+		}
+		else if (Candidate.Rejection == EClimbingDebugRejection::Filters)
+		{
+			Description = GetRejectionName(Candidate.Rejection);
+		}
+		else
+		{
+			Description = FString::Printf(TEXT("%d, %s"), FMath::RoundToInt(Candidate.Rating), GetRejectionName(Candidate.Rejection));
+		}
+
+		AddShape(FGameplayDebuggerShape::MakePoint(Candidate.Location, 20.0f, GetRejectionColor(Candidate.Rejection), Description));
+	}
+
+	if (Snapshot.Picked.IsValid() && Climbing->CharacterCapsule != nullptr)
+	{
+		const auto HangingLocation = Snapshot.PickedHangingTransform.GetLocation();
+		AddShape(FGameplayDebuggerShape::MakeCapsule(HangingLocation, Climbing->CharacterCapsule->GetScaledCapsuleRadius(),
+			Climbing->CharacterCapsule->GetScaledCapsuleHalfHeight(), FColor::Green, TEXT("Hanging")));
+		AddShape(FGameplayDebuggerShape::MakeSegment(HangingLocation,
+			HangingLocation + Snapshot.PickedHangingTransform.GetRotation().GetForwardVector() * 200.0f, 3.0f, FColor::Green));
+	}
+}
+
+#endif
@@ -0,0 +1,31 @@
+/* Copyright 2019 Alexandrea Shackelford, Zion Nimchuk, All Rights Reserved.
+ * Unauthorized copying or modification of this file, via any medium is strictly prohibited.
+ */
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ClimbingDebug.h"
+
+#if WITH_GAMEPLAY_DEBUGGER && WITH_CLIMBING_DEBUG
+
+#include "GameplayDebuggerCategory.h"
+
+class APlayerController;
+class AActor;
+
+/**
+ * Shows what the debug actor's climbing component detected and picked on its last FindBestClimbable, with every candidate's rating
+ * and why it was turned down. It's registered on its own at engine init, open it with the Gameplay Debugger's "Climbing" category.
+ */
+class FGameplayDebuggerCategory_Climbing : public FGameplayDebuggerCategory
+{
+public:
+
+	FGameplayDebuggerCategory_Climbing();
+
+	virtual void CollectData(APlayerController* OwnerPC, AActor* DebugActor) override;
+
+	static TSharedRef<FGameplayDebuggerCategory> MakeInstance();
+};
+
+#endif